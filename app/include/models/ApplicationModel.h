@@ -1,8 +1,10 @@
 #pragma once
 
 #include <QDateTime>
+#include <QMutex>
 #include <QString>
 #include "models/BaseModel.h"
+#include "models/StatusHistory.h"
 
 /**
  * @brief Main application model
@@ -17,6 +19,16 @@ public:
     explicit ApplicationModel(QObject *parent = nullptr);
     virtual ~ApplicationModel() = default;
 
+    // Compile-time property IDs, in the slot order of propertyNames()
+    using AppName = ModelProperty<QString, 0>;
+    using AppVersion = ModelProperty<QString, 1>;
+    using AppTitle = ModelProperty<QString, 2>;
+    using StatusMessage = ModelProperty<QString, 3>;
+    using IsBusy = ModelProperty<bool, 4>;
+    using LastUpdated = ModelProperty<QDateTime, 5>;
+    using UserName = ModelProperty<QString, 6>;
+    using Theme = ModelProperty<QString, 7>;
+
     // Property names as constants
     static const QString PROPERTY_APP_NAME;
     static const QString PROPERTY_APP_VERSION;
@@ -27,6 +39,9 @@ public:
     static const QString PROPERTY_USER_NAME;
     static const QString PROPERTY_THEME;
 
+    // Derived from appName, appVersion and statusMessage
+    static const QString PROPERTY_WINDOW_TITLE;
+
     // Convenience getters
     QString getAppName() const;
     QString getAppVersion() const;
@@ -36,6 +51,7 @@ public:
     QDateTime getLastUpdated() const;
     QString getUserName() const;
     QString getTheme() const;
+    QString getWindowTitle() const;
 
     // Convenience setters
     void setAppName(const QString &name);
@@ -49,18 +65,27 @@ public:
 
     // Business logic methods
     void updateStatus(const QString &message);
+
+    /**
+     * @brief Get the most recent messages passed to updateStatus()
+     * @return The entries, oldest first
+     */
+    QList<StatusHistory::Entry> getStatusHistory() const;
+
+    /**
+     * @brief Set how many status messages the history keeps
+     * @param capacity The number of entries
+     */
+    void setStatusHistoryCapacity(int capacity);
     void clearStatus();
     bool loadSettings();
     bool saveSettings();
 
 protected:
     bool initializeModel() override;
-    bool validateModel() const override;
     void resetModel() override;
     bool beforePropertySet(const QString &propertyName,
                            const QVariant &value) override;
-    void afterPropertySet(const QString &propertyName, const QVariant &oldValue,
-                          const QVariant &newValue) override;
 
 signals:
     /**
@@ -92,6 +117,10 @@ signals:
     void settingsSaved();
 
 private:
+    static const ModelPropertyTable &propertyNames();
     void initializeDefaults();
     bool isValidTheme(const QString &theme) const;
+
+    StatusHistory m_statusHistory;
+    mutable QMutex m_statusHistoryMutex;
 };
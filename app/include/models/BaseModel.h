@@ -1,16 +1,52 @@
 #pragma once
 
+#include <QAtomicInteger>
+#include <QBitArray>
 #include <QHash>
+#include <QList>
+#include <QMetaType>
 #include <QMutex>
+#include <QReadWriteLock>
+#include <QRecursiveMutex>
+#include <QSet>
 #include <QString>
 #include <QVariant>
+#include <functional>
 #include "interfaces/IModel.h"
+#include "models/ModelChangeJournal.h"
+#include "models/ModelMailbox.h"
+#include "models/ModelPropertyTable.h"
+#include "models/ModelSnapshot.h"
+#include "models/PropertyUpdate.h"
+
+class ModelRecorder;
+class QTimer;
 
 /**
  * @brief Base implementation of IModel interface
  *
  * This class provides a basic implementation of the IModel interface
  * with property management and thread safety.
+ *
+ * Derived models can declare their properties up front through a
+ * ModelPropertyTable and ModelProperty aliases. Declared properties live in
+ * a contiguous array indexed by slot; get() and set() access them by slot
+ * without hashing a name. Properties that are not declared are kept in a
+ * hash, and the string-based API works for both kinds.
+ *
+ * Properties are guarded by a read-write lock, so any number of threads
+ * can read the model concurrently; only writers take the lock exclusively.
+ *
+ * With undo enabled, every change set is recorded in a ModelChangeJournal
+ * as the old/new values of the properties it changed, and undo()/redo()
+ * step back and forth through that history.
+ *
+ * snapshot() hands out a consistent, immutable view of all properties in
+ * O(1) for readers that need one for longer than a single property read.
+ *
+ * Threads other than the model's own post values with postProperty(); the
+ * model applies the latest posted value per property once per frame on
+ * its own thread.
  */
 class BaseModel : public IModel {
     Q_OBJECT
@@ -27,7 +63,318 @@ public:
                      const QVariant &value) override;
     void reset() override;
 
+    /**
+     * @brief Get a declared property value by slot
+     * @param slot The property slot
+     * @return The property value
+     */
+    QVariant getProperty(int slot) const;
+
+    /**
+     * @brief Set a declared property value by slot
+     * @param slot The property slot
+     * @param value The new value
+     * @return true if the property was set successfully
+     */
+    bool setProperty(int slot, const QVariant &value);
+
+    /**
+     * @brief Get a declared property with its declared type
+     * @tparam P The ModelProperty alias of the property
+     * @return The property value
+     */
+    template <typename P>
+    typename P::Type get() const {
+        return qvariant_cast<typename P::Type>(getProperty(P::slot));
+    }
+
+    /**
+     * @brief Set a declared property from a value of its declared type
+     * @tparam P The ModelProperty alias of the property
+     * @param value The new value
+     * @return true if the property was set successfully
+     */
+    template <typename P>
+    bool set(const typename P::Type &value) {
+        return setProperty(P::slot, QVariant::fromValue(value));
+    }
+
+    /**
+     * @brief Apply a batch of property changes as one transaction
+     *
+     * beforePropertySet() is consulted for every change first; vetoed
+     * changes are skipped. The remaining changes are stored under a single
+     * lock acquisition, then afterPropertySet() and propertyChanged() run
+     * for each property that changed, followed by one propertiesChanged(),
+     * one dataChanged() and one validity check for the whole batch.
+     *
+     * @param update The changes to apply
+     * @return true if no change was vetoed
+     */
+    bool applyUpdate(const PropertyUpdate &update);
+
+    /**
+     * @brief Set many properties at once, all or nothing
+     *
+     * Every value is checked with beforePropertySet() before anything is
+     * stored; if any is rejected, the model is left unchanged. Otherwise
+     * the values are stored as one transaction like applyUpdate(), with a
+     * single lock acquisition, one propertiesChanged(), one dataChanged()
+     * and one validity check.
+     *
+     * @param values New values keyed by property name
+     * @return true if all values were accepted and applied
+     */
+    bool setProperties(const QVariantHash &values);
+
+    /**
+     * @brief Get the table of declared properties
+     * @return The property table (empty if the model declares none)
+     */
+    const ModelPropertyTable &propertyTable() const;
+
+    /**
+     * @brief Queue a property value from any thread
+     *
+     * Posting is lock-free and never blocks. The model applies pending
+     * values on its own thread at most once per mailbox interval, as one
+     * transaction holding only the latest value posted for each property,
+     * so hooks and signals run on the model's thread. The model's thread
+     * needs a running event loop.
+     *
+     * @param propertyName The name of the property
+     * @param value The new value
+     */
+    void postProperty(const QString &propertyName, const QVariant &value);
+
+    /**
+     * @brief Queue a declared property value from any thread
+     * @param slot The property slot
+     * @param value The new value
+     */
+    void postProperty(int slot, const QVariant &value);
+
+    /**
+     * @brief Queue a declared property value of its declared type
+     * @tparam P The ModelProperty alias of the property
+     * @param value The new value
+     */
+    template <typename P>
+    void post(const typename P::Type &value) {
+        postProperty(P::slot, QVariant::fromValue(value));
+    }
+
+    /**
+     * @brief Set how often posted values are applied
+     * @param msecs The interval in milliseconds; defaults to one 60 Hz frame
+     */
+    void setMailboxInterval(int msecs);
+
+    /**
+     * @brief Apply all posted values now (model thread only)
+     * @return true if there were values to apply
+     */
+    bool drainMailbox();
+
+    /**
+     * @brief Record every change set of this model
+     *
+     * Recording is off by default. Change sets are handed to the recorder
+     * on the thread that made them, right before their notifications.
+     *
+     * @param recorder The recorder, or nullptr to stop recording; must
+     *                 outlive its use by the model
+     */
+    void setRecorder(ModelRecorder *recorder);
+
+    /**
+     * @brief Call a function whenever a declared property changes
+     *
+     * Subscribers are stored per slot, so dispatching a change is an
+     * indexed lookup with no name comparison. The callback receives the
+     * new value with the property's declared type; when the stored value
+     * already has that type it is passed by reference without conversion.
+     * Callbacks run after afterPropertySet() and before propertyChanged(),
+     * on the thread that made the change.
+     *
+     * @tparam P The ModelProperty alias of the property
+     * @param callback Called as callback(const typename P::Type &value)
+     * @return An ID for unsubscribe()
+     */
+    template <typename P, typename Callback>
+    int subscribe(Callback callback) {
+        using T = typename P::Type;
+        return addSubscriber(
+            P::slot, [callback = std::move(callback)](const QVariant &value) {
+                if (value.metaType() == QMetaType::fromType<T>()) {
+                    callback(*static_cast<const T *>(value.constData()));
+                } else {
+                    callback(qvariant_cast<T>(value));
+                }
+            });
+    }
+
+    /**
+     * @brief Remove a subscription
+     * @param subscriptionId The ID returned by subscribe()
+     */
+    void unsubscribe(int subscriptionId);
+
+    /**
+     * @brief Take an immutable view of the current properties
+     *
+     * The snapshot shares storage with the model; the model copies it on
+     * its next write, so taking a snapshot is O(1) and never blocks the
+     * model for longer than a single property read.
+     *
+     * @return The snapshot
+     */
+    ModelSnapshot snapshot() const;
+
+    /**
+     * @brief Get the current model version
+     *
+     * The version increases with every stored property change, so a
+     * snapshot is stale when its version differs from this one. Reading
+     * the version does not take the lock.
+     *
+     * @return The version
+     */
+    quint64 version() const;
+
+    /**
+     * @brief Check if any property changed since its dirty flag was cleared
+     *
+     * Every stored change marks its property dirty, including silent sets,
+     * undo and clearing the model. Persistence code uses the flags to write
+     * only what changed.
+     *
+     * @return true if at least one property is dirty
+     */
+    bool isDirty() const;
+
+    /**
+     * @brief Check if a property changed since its dirty flag was cleared
+     * @param propertyName The name of the property
+     * @return true if the property is dirty
+     */
+    bool isDirty(const QString &propertyName) const;
+
+    /**
+     * @brief Check if a declared property is dirty
+     * @tparam P The ModelProperty alias of the property
+     * @return true if the property is dirty
+     */
+    template <typename P>
+    bool isDirty() const {
+        QReadLocker locker(&m_lock);
+        return m_dirtySlots.testBit(P::slot);
+    }
+
+    /**
+     * @brief Get the names of all dirty properties
+     * @return Declared properties in slot order, then undeclared ones
+     */
+    QStringList dirtyPropertyNames() const;
+
+    /**
+     * @brief Clear the dirty flags of some properties
+     *
+     * Checking and clearing happen atomically, so a change made while the
+     * caller persists the returned properties marks them dirty again.
+     *
+     * @param propertyNames The properties to clear
+     * @return The subset of @p propertyNames that was dirty
+     */
+    QStringList takeDirty(const QStringList &propertyNames);
+
+    /**
+     * @brief Mark properties dirty again
+     *
+     * Used when persisting properties returned by takeDirty() failed.
+     *
+     * @param propertyNames The properties to mark
+     */
+    void markDirty(const QStringList &propertyNames);
+
+    /**
+     * @brief Clear the dirty flags of all properties
+     */
+    void clearDirty();
+
+    /**
+     * @brief Enable or disable recording of undo history
+     *
+     * Disabling discards the recorded history. Undo is disabled by default.
+     *
+     * @param enabled true to record changes
+     */
+    void setUndoEnabled(bool enabled);
+
+    /**
+     * @brief Check if undo history is recorded
+     * @return true if enabled
+     */
+    bool isUndoEnabled() const;
+
+    /**
+     * @brief Revert the most recent change set
+     *
+     * The old values are applied as one transaction, so hooks and change
+     * signals run as for any other update. If beforePropertySet() vetoes
+     * any of them, nothing is applied and the change set stays in the
+     * undo history.
+     *
+     * @return true if a change set was reverted
+     */
+    bool undo();
+
+    /**
+     * @brief Re-apply the most recently reverted change set
+     *
+     * Like undo(), a vetoed change set is not applied and stays in the
+     * redo history.
+     *
+     * @return true if a change set was re-applied
+     */
+    bool redo();
+
+    bool canUndo() const;
+    bool canRedo() const;
+
+    /**
+     * @brief Discard the recorded undo and redo history
+     */
+    void clearUndoHistory();
+
+    /**
+     * @brief Set the approximate memory the undo history may use
+     *
+     * The oldest change sets are evicted once the limit is exceeded.
+     *
+     * @param bytes The limit in bytes
+     */
+    void setUndoMemoryLimit(qint64 bytes);
+
+    /**
+     * @brief Set the interval within which edits of a property are merged
+     *
+     * Consecutive single-property changes of the same property closer than
+     * this are undone as one step.
+     *
+     * @param msecs The interval in milliseconds, or 0 to never merge
+     */
+    void setUndoMergeInterval(qint64 msecs);
+
 protected:
+    /**
+     * @brief Create a model with declared properties
+     * @param table The declared properties; must outlive the model
+     * @param parent The parent object
+     */
+    explicit BaseModel(const ModelPropertyTable &table,
+                       QObject *parent = nullptr);
+
     /**
      * @brief Initialize model-specific data
      * Override this method in derived classes for custom initialization
@@ -37,11 +384,45 @@ protected:
 
     /**
      * @brief Validate the model state
-     * Override this method in derived classes for custom validation
+     * Override this method in derived classes for custom validation.
+     * It runs on every validity check; prefer addValidator() for checks
+     * that depend on specific properties.
      * @return true if the model is valid
      */
     virtual bool validateModel() const;
 
+    /**
+     * @brief Register a validity check that depends on some properties
+     *
+     * The check is re-run only after one of its dependencies changed and
+     * its result is cached in between. The model is valid when it is
+     * initialized, all registered checks pass and validateModel() passes.
+     *
+     * @param dependencies Names of the properties the check reads
+     * @param check Returns true if the model passes the check
+     */
+    void addValidator(const QStringList &dependencies,
+                      std::function<bool()> check);
+
+    /**
+     * @brief Declare a read-only property computed from other properties
+     *
+     * The properties @p compute reads are recorded while it runs, so the
+     * dependencies need not be listed and may differ between runs. The
+     * value is cached and recomputed only when read after one of them
+     * changed. Once per event loop iteration after such a change, the
+     * model checks the value and emits propertyChanged() only if it
+     * actually differs from the last one announced.
+     *
+     * Derived properties are read with getProperty() like any other;
+     * setting one is rejected.
+     *
+     * @param propertyName The name of the derived property
+     * @param compute Computes the value from other properties
+     */
+    void addDerivedProperty(const QString &propertyName,
+                            std::function<QVariant()> compute);
+
     /**
      * @brief Reset model-specific data
      * Override this method in derived classes for custom reset logic
@@ -94,8 +475,101 @@ protected:
      */
     void clearProperties();
 
+signals:
+    /**
+     * @brief Emitted once per change set with every property it changed
+     * @param propertyNames The names of the changed properties
+     */
+    void propertiesChanged(const QStringList &propertyNames);
+
 private:
+    using PropertyChange = ModelPropertyChange;
+
+    struct Validator {
+        std::function<bool()> check;
+        bool stale;
+        bool valid;
+    };
+
+    struct DerivedProperty {
+        QString name;
+        std::function<QVariant()> compute;
+        QVariant notifiedValue;
+        QSet<QString> dependencies;
+        bool evaluated;
+        bool pendingCheck;
+    };
+
+    struct DerivedCache {
+        QVariant value;
+        bool stale;
+    };
+
+    struct Subscriber {
+        int id;
+        std::function<void(const QVariant &)> deliver;
+    };
+
+    void postEntry(int slot, const QString &propertyName,
+                   const QVariant &value);
+    void scheduleMailboxDrain();
+    int addSubscriber(int slot,
+                      std::function<void(const QVariant &)> deliver);
+    enum CommitMode { PartialCommit, AllOrNothing };
+
+    bool commitUpdate(const PropertyUpdate &update, bool record,
+                      CommitMode mode = PartialCommit);
+    int derivedIndex(const QString &propertyName) const;
+    QVariant derivedValue(int index) const;
+    void invalidateDerived(const QStringList &propertyNames);
+    void invalidateAllDerived();
+    void queueDerivedCheck();
+    void checkDerivedProperties();
+    void notifyChanges(const QList<PropertyChange> &changes);
+    void invalidateValidators(const QStringList &propertyNames);
+    void invalidateAllValidators();
+    void updateValidity();
+    void storeProperty(int slot, const QString &propertyName,
+                       const QVariant &value);
+
+    const ModelPropertyTable *m_table;
+    QList<QVariant> m_values;
     QHash<QString, QVariant> m_properties;
-    mutable QMutex m_mutex;
+    mutable QReadWriteLock m_lock;
     bool m_initialized;
+    QAtomicInteger<quint64> m_version;
+    QBitArray m_dirtySlots;
+    QSet<QString> m_dirtyProperties;
+    bool m_undoEnabled;
+    ModelChangeJournal m_journal;
+
+    // Indexed by slot; copied out under m_lock before callbacks run
+    QList<QList<Subscriber>> m_subscribers;
+    int m_nextSubscriptionId;
+    ModelRecorder *m_recorder;
+
+    ModelMailbox m_mailbox;
+    QTimer *m_mailboxTimer;
+    int m_mailboxInterval;
+
+    // Cached validator results; checks read properties, so this mutex is
+    // never taken while m_lock is held. The counters are atomic so that
+    // isValid() can skip the mutex when no check needs to run again.
+    mutable QList<Validator> m_validators;
+    QHash<QString, QList<int>> m_validatorsByProperty;
+    mutable QAtomicInt m_staleValidators;
+    mutable QAtomicInt m_failingValidators;
+    bool m_lastValidity;
+    mutable QMutex m_validationMutex;
+
+    // Derived properties; computing one reads properties, so this mutex is
+    // never taken while m_lock is held. It is recursive because a derived
+    // property may read another one. The name index and the cached values
+    // are guarded by m_lock so that reads take only the shared lock.
+    mutable QList<DerivedProperty> m_derived;
+    QHash<QString, int> m_derivedIndex;
+    mutable QList<DerivedCache> m_derivedCache;
+    mutable QHash<QString, QSet<int>> m_derivedByDependency;
+    bool m_derivedCheckQueued;
+    mutable QRecursiveMutex m_derivedMutex;
 };
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QString>
+#include <QVariant>
+
+/**
+ * @brief A single property change, as an old/new value pair
+ *
+ * slot is the property's slot for declared properties and -1 otherwise.
+ */
+struct ModelPropertyChange {
+    int slot;
+    QString name;
+    QVariant oldValue;
+    QVariant newValue;
+};
+
+/**
+ * @brief Undo/redo history of model changes
+ *
+ * Each step holds the changes of one change set (a single setProperty()
+ * or a whole BaseModel::applyUpdate() transaction) as old/new pairs of
+ * only the properties that changed. Consecutive edits of the same single
+ * property within the merge interval are folded into one step. History
+ * is bounded by an approximate memory limit; the oldest steps are evicted
+ * first. Appending is O(1) amortized and undoing a step costs O(changes
+ * in the step).
+ *
+ * The journal is not thread-safe; BaseModel guards it with its own lock.
+ */
+class ModelChangeJournal {
+public:
+    using Step = QList<ModelPropertyChange>;
+
+    static constexpr qint64 DefaultMemoryLimit = 1024 * 1024;
+    static constexpr qint64 DefaultMergeInterval = 500;
+
+    ModelChangeJournal();
+
+    /**
+     * @brief Record a change set as a new undo step
+     *
+     * Clears the redo history.
+     *
+     * @param changes The changes of the change set
+     */
+    void record(const Step &changes);
+
+    /**
+     * @brief Take the newest undo step and move it to the redo history
+     * @return The step, or an empty step if there is nothing to undo
+     */
+    Step takeUndo();
+
+    /**
+     * @brief Take the newest redo step and move it to the undo history
+     * @return The step, or an empty step if there is nothing to redo
+     */
+    Step takeRedo();
+
+    /**
+     * @brief Move the step taken by takeUndo() back to the undo history
+     *
+     * Used when the step could not be applied. Does nothing if the history
+     * changed since the step was taken.
+     */
+    void restoreUndo();
+
+    /**
+     * @brief Move the step taken by takeRedo() back to the redo history
+     */
+    void restoreRedo();
+
+    bool canUndo() const;
+    bool canRedo() const;
+    int undoCount() const;
+    int redoCount() const;
+
+    /**
+     * @brief Discard all history
+     */
+    void clear();
+
+    /**
+     * @brief Set the approximate memory the history may use
+     * @param bytes The limit in bytes
+     */
+    void setMemoryLimit(qint64 bytes);
+    qint64 memoryLimit() const;
+
+    /**
+     * @brief Get the approximate memory used by the history
+     * @return Size in bytes
+     */
+    qint64 memoryUsage() const;
+
+    /**
+     * @brief Set the interval within which edits of a property are merged
+     * @param msecs The interval in milliseconds, or 0 to never merge
+     */
+    void setMergeInterval(qint64 msecs);
+    qint64 mergeInterval() const;
+
+private:
+    static qint64 stepSize(const Step &step);
+    void evict();
+
+    QList<Step> m_undo;
+    QList<Step> m_redo;
+    qint64 m_memoryUsage;
+    qint64 m_memoryLimit;
+    qint64 m_mergeInterval;
+    qint64 m_lastRecordTime;
+    bool m_mergeable;
+    // The newest step of one history was just taken from the other
+    bool m_restorable;
+    QElapsedTimer m_clock;
+};
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <QString>
+#include <QVariant>
+#include <atomic>
+#include "models/PropertyUpdate.h"
+
+/**
+ * @brief Lock-free multi-producer, single-consumer queue of property values
+ *
+ * Any number of threads post values; one thread takes everything posted
+ * so far in one step. Posting is a single compare-and-swap on the list
+ * head and never blocks, so fast producers cannot stall each other or
+ * the consumer. Taking collapses the pending values to the latest one per
+ * property.
+ */
+class ModelMailbox {
+public:
+    ModelMailbox();
+    ~ModelMailbox();
+
+    ModelMailbox(const ModelMailbox &) = delete;
+    ModelMailbox &operator=(const ModelMailbox &) = delete;
+
+    /**
+     * @brief Post a value (thread-safe)
+     * @param slot The property slot, or -1 to address it by name
+     * @param propertyName The property name when slot is -1
+     * @param value The new value
+     * @return true if the mailbox was empty before, i.e. the consumer has
+     *         to be woken up
+     */
+    bool post(int slot, const QString &propertyName, const QVariant &value);
+
+    /**
+     * @brief Take all pending values (consumer thread only)
+     * @return The latest value per property, oldest property first
+     */
+    PropertyUpdate take();
+
+    /**
+     * @brief Check if values are pending
+     * @return true if nothing was posted since the last take()
+     */
+    bool isEmpty() const;
+
+private:
+    struct Node {
+        int slot;
+        QString name;
+        QVariant value;
+        Node *next;
+    };
+
+    std::atomic<Node *> m_head;
+};
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <initializer_list>
+
+/**
+ * @brief Compile-time ID of a declared model property
+ *
+ * Derived models declare each of their properties as an alias of this
+ * template, e.g. `using Theme = ModelProperty<QString, 7>;`. The slot is
+ * the property's index in the model's contiguous value array, so typed
+ * access through BaseModel::get() and BaseModel::set() is an indexed load
+ * rather than a string hash lookup.
+ *
+ * @tparam T The value type of the property
+ * @tparam Slot The index of the property in its model's property table
+ */
+template <typename T, int Slot>
+struct ModelProperty {
+    using Type = T;
+    static constexpr int slot = Slot;
+};
+
+/**
+ * @brief Names of the properties a model declares, indexed by slot
+ *
+ * A table is built once per model class and shared by all instances. It
+ * maps property names to slots so that the string-based property API
+ * keeps working for declared properties.
+ */
+class ModelPropertyTable {
+public:
+    ModelPropertyTable() = default;
+
+    /**
+     * @brief Create a table from property names in slot order
+     * @param names The property names; the first one gets slot 0
+     */
+    ModelPropertyTable(std::initializer_list<QString> names);
+
+    /**
+     * @brief Get the slot of a property
+     * @param name The property name
+     * @return The slot, or -1 if the property is not declared
+     */
+    int slot(const QString &name) const;
+
+    /**
+     * @brief Get the name of a slot
+     * @param slot The slot
+     * @return The property name, or an empty string for an invalid slot
+     */
+    QString name(int slot) const;
+
+    /**
+     * @brief Get all declared property names in slot order
+     * @return The property names
+     */
+    const QStringList &names() const;
+
+    /**
+     * @brief Get the number of declared properties
+     * @return The property count
+     */
+    int size() const;
+
+private:
+    QStringList m_names;
+    QHash<QString, int> m_slots;
+};
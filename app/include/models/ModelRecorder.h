@@ -0,0 +1,56 @@
+#pragma once
+
+#include <QDataStream>
+#include <QElapsedTimer>
+#include <QIODevice>
+#include <QList>
+#include <QMutex>
+#include "models/ModelChangeJournal.h"
+
+/**
+ * @brief Writes every change set of a model to a binary stream
+ *
+ * Attach a recorder with BaseModel::setRecorder(). Each change set
+ * becomes one record: the milliseconds since recording started and the
+ * new value of each changed property. Declared properties are identified
+ * by slot, undeclared ones by name, so a recording replays into models of
+ * the same class. ModelReplayer feeds a recording back into a model.
+ *
+ * record() is thread-safe; the device must stay open while recording.
+ */
+class ModelRecorder {
+public:
+    static constexpr quint32 Magic = 0x514D5243;  // "QMRC"
+    static constexpr quint16 FormatVersion = 1;
+    static constexpr QDataStream::Version StreamVersion = QDataStream::Qt_6_0;
+
+    /**
+     * @brief Start a recording and write its header
+     * @param device An open, writable device
+     */
+    explicit ModelRecorder(QIODevice *device);
+
+    /**
+     * @brief Append one change set (thread-safe)
+     * @param changes The changes; only slot, name and newValue are stored
+     */
+    void record(const QList<ModelPropertyChange> &changes);
+
+    /**
+     * @brief Get the number of change sets recorded so far
+     * @return The record count
+     */
+    int recordCount() const;
+
+    /**
+     * @brief Check if everything so far was written successfully
+     * @return true if no write failed
+     */
+    bool isOk() const;
+
+private:
+    mutable QMutex m_mutex;
+    QDataStream m_stream;
+    QElapsedTimer m_clock;
+    int m_recordCount;
+};
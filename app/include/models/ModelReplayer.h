@@ -0,0 +1,86 @@
+#pragma once
+
+#include <QDataStream>
+#include <QElapsedTimer>
+#include <QIODevice>
+#include <QObject>
+#include <QPointer>
+#include "models/PropertyUpdate.h"
+
+class BaseModel;
+class QTimer;
+
+/**
+ * @brief Feeds a ModelRecorder recording back into a model
+ *
+ * Every recorded change set is applied with BaseModel::applyUpdate(), so
+ * hooks, signals and views react exactly as they did when it was
+ * recorded. RealTime mode keeps the recorded timing, which makes a
+ * recording usable as a realistic load generator; AsFastAsPossible applies
+ * everything without waiting.
+ */
+class ModelReplayer : public QObject {
+    Q_OBJECT
+
+public:
+    enum Mode { RealTime, AsFastAsPossible };
+
+    /**
+     * @brief Create a replayer
+     * @param device An open, readable device holding a recording
+     * @param model The model to apply the recording to
+     * @param parent The parent object
+     */
+    ModelReplayer(QIODevice *device, BaseModel *model,
+                  QObject *parent = nullptr);
+
+    /**
+     * @brief Start replaying
+     *
+     * In RealTime mode the change sets are applied from the event loop at
+     * their recorded offsets from now. In AsFastAsPossible mode they are
+     * all applied before this returns.
+     *
+     * @param mode The replay mode
+     * @return false if the device does not hold a supported recording
+     */
+    bool start(Mode mode);
+
+    /**
+     * @brief Stop a real-time replay
+     */
+    void stop();
+
+    /**
+     * @brief Check if a real-time replay is in progress
+     * @return true while replaying
+     */
+    bool isRunning() const;
+
+    /**
+     * @brief Get the number of change sets applied so far
+     * @return The count
+     */
+    int replayedCount() const;
+
+signals:
+    /**
+     * @brief Emitted when the end of the recording is reached
+     * @param ok false if the recording was truncated or corrupt
+     */
+    void finished(bool ok);
+
+private:
+    bool readNext();
+    void applyDue();
+    void finish(bool ok);
+
+    QDataStream m_stream;
+    QPointer<BaseModel> m_model;
+    QTimer *m_timer;
+    QElapsedTimer m_clock;
+    PropertyUpdate m_next;
+    qint64 m_nextTime;
+    int m_replayedCount;
+    bool m_running;
+};
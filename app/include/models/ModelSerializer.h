@@ -0,0 +1,63 @@
+#pragma once
+
+#include <QByteArray>
+#include <QIODevice>
+#include <QString>
+#include "models/ModelSnapshot.h"
+#include "models/PropertyUpdate.h"
+
+class BaseModel;
+
+/**
+ * @brief Versioned binary format for model properties
+ *
+ * The format is a small header followed by one record per property:
+ * the property name and its length-prefixed QDataStream value. Records
+ * are matched by name when they are read back, so a model whose property
+ * table gained, lost or reordered properties still loads older data;
+ * values of types the reader does not know are skipped.
+ *
+ * Writing streams records to any QIODevice from a snapshot, without
+ * holding the model lock. Reading decodes straight from a memory-mapped
+ * file without copying it into memory first.
+ */
+class ModelSerializer {
+public:
+    static constexpr quint16 FormatVersion = 1;
+
+    /**
+     * @brief Write the properties of a snapshot to a device
+     * @param snapshot The properties to write
+     * @param device An open, writable device
+     * @return true if all data was written
+     */
+    static bool write(const ModelSnapshot &snapshot, QIODevice *device);
+
+    /**
+     * @brief Decode serialized properties
+     * @param data The serialized data; may wrap a memory-mapped file
+     * @param update Receives one change per stored property, by name
+     * @return true if the data was in a supported format and complete
+     */
+    static bool read(const QByteArray &data, PropertyUpdate *update);
+
+    /**
+     * @brief Atomically save the current properties of a model to a file
+     * @param model The model to save
+     * @param filePath The destination file
+     * @return true if the file was committed
+     */
+    static bool save(const BaseModel &model, const QString &filePath);
+
+    /**
+     * @brief Load properties from a file into a model
+     *
+     * The stored properties are applied as one transaction. Properties of
+     * the model that are not in the file keep their values.
+     *
+     * @param filePath The file to load
+     * @param model The model to update
+     * @return true if the file was read successfully
+     */
+    static bool load(const QString &filePath, BaseModel *model);
+};
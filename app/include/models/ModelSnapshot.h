@@ -0,0 +1,79 @@
+#pragma once
+
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QVariant>
+#include "models/ModelPropertyTable.h"
+
+/**
+ * @brief Immutable, versioned view of a model's properties
+ *
+ * Returned by BaseModel::snapshot(). The snapshot shares its storage with
+ * the model through implicit sharing, so taking one copies no values;
+ * the model copies its storage only when it is next written while the
+ * snapshot is alive. A snapshot never changes afterwards and can be read
+ * from any thread without locking.
+ *
+ * Compare version() with BaseModel::version() to find out whether the
+ * model changed since the snapshot was taken.
+ */
+class ModelSnapshot {
+public:
+    ModelSnapshot();
+
+    /**
+     * @brief Create a snapshot of model storage
+     * @param table The declared properties of the model
+     * @param values The values of the declared properties, by slot
+     * @param properties The values of undeclared properties
+     * @param version The model version the values belong to
+     */
+    ModelSnapshot(const ModelPropertyTable *table,
+                  const QList<QVariant> &values,
+                  const QHash<QString, QVariant> &properties,
+                  quint64 version);
+
+    /**
+     * @brief Get the model version the snapshot was taken at
+     * @return The version; 0 for a default-constructed snapshot
+     */
+    quint64 version() const;
+
+    /**
+     * @brief Get a property value by name
+     * @param propertyName The name of the property
+     * @return The value, or an invalid QVariant if it is not set
+     */
+    QVariant value(const QString &propertyName) const;
+
+    /**
+     * @brief Get a declared property value by slot
+     * @param slot The property slot
+     * @return The value, or an invalid QVariant if it is not set
+     */
+    QVariant value(int slot) const;
+
+    /**
+     * @brief Get a declared property with its declared type
+     * @tparam P The ModelProperty alias of the property
+     * @return The property value
+     */
+    template <typename P>
+    typename P::Type get() const {
+        return qvariant_cast<typename P::Type>(value(P::slot));
+    }
+
+    /**
+     * @brief Get the names of all properties that are set
+     * @return Declared properties in slot order, then undeclared ones
+     */
+    QStringList propertyNames() const;
+
+private:
+    const ModelPropertyTable *m_table;
+    QList<QVariant> m_values;
+    QHash<QString, QVariant> m_properties;
+    quint64 m_version;
+};
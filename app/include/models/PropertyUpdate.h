@@ -0,0 +1,79 @@
+#pragma once
+
+#include <QList>
+#include <QString>
+#include <QVariant>
+#include "models/ModelPropertyTable.h"
+
+/**
+ * @brief Batch of property changes applied to a model in one step
+ *
+ * Collect changes with set() and pass the batch to BaseModel::applyUpdate().
+ * The model applies all of them under a single lock acquisition and emits
+ * one coalesced change notification for the whole batch.
+ */
+class PropertyUpdate {
+public:
+    /**
+     * @brief A single change; slot is -1 when it is addressed by name
+     */
+    struct Entry {
+        int slot;
+        QString name;
+        QVariant value;
+    };
+
+    /**
+     * @brief Add a change addressed by property name
+     * @param propertyName The name of the property
+     * @param value The new value
+     * @return This update, for chaining
+     */
+    PropertyUpdate &set(const QString &propertyName, const QVariant &value) {
+        m_entries.append({-1, propertyName, value});
+        return *this;
+    }
+
+    /**
+     * @brief Add a change to a declared property
+     * @tparam P The ModelProperty alias of the property
+     * @param value The new value
+     * @return This update, for chaining
+     */
+    template <typename P>
+    PropertyUpdate &set(const typename P::Type &value) {
+        return set(P::slot, QVariant::fromValue(value));
+    }
+
+    /**
+     * @brief Add a change to a declared property addressed by slot
+     * @param slot The property slot
+     * @param value The new value
+     * @return This update, for chaining
+     */
+    PropertyUpdate &set(int slot, const QVariant &value) {
+        m_entries.append({slot, QString(), value});
+        return *this;
+    }
+
+    /**
+     * @brief Get the collected changes in the order they were added
+     * @return The changes
+     */
+    const QList<Entry> &entries() const { return m_entries; }
+
+    /**
+     * @brief Check if the update contains no changes
+     * @return true if empty
+     */
+    bool isEmpty() const { return m_entries.isEmpty(); }
+
+    /**
+     * @brief Reserve room for a number of changes
+     * @param size The expected number of changes
+     */
+    void reserve(qsizetype size) { m_entries.reserve(size); }
+
+private:
+    QList<Entry> m_entries;
+};
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <QHash>
+#include <QList>
+#include <QString>
+
+/**
+ * @brief Fixed-capacity history of status messages
+ *
+ * Entries live in a ring buffer that overwrites the oldest entry once it
+ * is full, so memory stays constant however long the application runs.
+ * Message texts are interned in a reference-counted pool: a message that
+ * recurs, such as a periodic "Ready", is stored once and recording it
+ * again allocates nothing. The pool never holds more strings than the
+ * history has entries.
+ *
+ * The history is not thread-safe.
+ */
+class StatusHistory {
+public:
+    static constexpr int DefaultCapacity = 64;
+
+    /**
+     * @brief A recorded status message
+     */
+    struct Entry {
+        qint64 timestamp;  // Milliseconds since the epoch
+        QString message;
+    };
+
+    explicit StatusHistory(int capacity = DefaultCapacity);
+
+    /**
+     * @brief Record a message, evicting the oldest entry when full
+     * @param message The status message
+     * @param timestamp Milliseconds since the epoch
+     */
+    void record(const QString &message, qint64 timestamp);
+
+    /**
+     * @brief Get the recorded messages
+     * @return The entries, oldest first
+     */
+    QList<Entry> entries() const;
+
+    /**
+     * @brief Get the number of recorded entries
+     * @return The entry count, at most capacity()
+     */
+    int size() const;
+
+    int capacity() const;
+
+    /**
+     * @brief Change the capacity, keeping the newest entries
+     * @param capacity The new capacity; at least 1
+     */
+    void setCapacity(int capacity);
+
+    /**
+     * @brief Get the number of distinct messages held
+     * @return The size of the string pool
+     */
+    int poolSize() const;
+
+    /**
+     * @brief Remove all entries
+     */
+    void clear();
+
+private:
+    struct Slot {
+        qint64 timestamp;
+        int string;
+    };
+
+    int intern(const QString &message);
+    void release(int string);
+
+    QList<Slot> m_ring;
+    int m_head;
+    int m_size;
+
+    // Interned messages with their reference counts; freed indices are
+    // reused before the pool grows
+    QList<QString> m_strings;
+    QList<int> m_refCounts;
+    QList<int> m_freeStrings;
+    QHash<QString, int> m_stringIndex;
+};
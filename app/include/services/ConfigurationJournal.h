@@ -0,0 +1,147 @@
+#pragma once
+
+#include <QFile>
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QVariant>
+
+/**
+ * @brief Append-only storage for the user configuration layer
+ *
+ * The journal directory holds a base snapshot and a sequence of numbered
+ * journal segments. Every change is appended to the newest segment as a
+ * small length-prefixed, checksummed record, so a write costs O(1)
+ * regardless of how many keys are stored. On open the snapshot is loaded
+ * and all newer segments are replayed; a record that was only partially
+ * written before a crash fails its checksum and is truncated away. Only
+ * the newest segment can have such a torn tail: damage in an older,
+ * sealed segment is reported and the file is left untouched, so the
+ * records of the segments after it still apply.
+ *
+ * Compaction folds the journal into a new snapshot in two steps: rotate()
+ * starts a new segment on the owner thread, then writeSnapshot() and
+ * removeSegmentsBefore() can run on a worker thread while new records keep
+ * going to the new segment. A snapshot records the first segment it does
+ * not contain, so a compaction interrupted at any point is still replayed
+ * correctly.
+ */
+class ConfigurationJournal {
+public:
+    static constexpr qint64 DefaultCompactionThreshold = 4 * 1024 * 1024;
+
+    explicit ConfigurationJournal(const QString &directory);
+    ~ConfigurationJournal();
+
+    /**
+     * @brief Open the journal and replay its contents
+     * @param values Receives the stored configuration
+     * @return true if the journal could be opened for appending
+     */
+    bool open(QHash<QString, QVariant> *values);
+
+    /**
+     * @brief Check if the journal held any state when it was opened
+     * @return true if neither a snapshot nor records were found
+     */
+    bool isEmpty() const;
+
+    /**
+     * @brief Append a record that sets a key
+     * @param key The configuration key
+     * @param value The new value
+     * @return true if the record was written
+     */
+    bool appendSet(const QString &key, const QVariant &value);
+
+    /**
+     * @brief Append a record that removes a key
+     * @param key The configuration key
+     * @return true if the record was written
+     */
+    bool appendRemove(const QString &key);
+
+    /**
+     * @brief Append a record that removes all keys
+     * @return true if the record was written
+     */
+    bool appendClear();
+
+    /**
+     * @brief Flush appended records and sync them to disk
+     * @return true if successful
+     */
+    bool sync();
+
+    /**
+     * @brief Get the size of the journal segment being appended to
+     * @return Size in bytes
+     */
+    qint64 size() const;
+
+    /**
+     * @brief Set the segment size above which compaction is due
+     * @param bytes The threshold in bytes
+     */
+    void setCompactionThreshold(qint64 bytes);
+
+    /**
+     * @brief Check if the current segment has outgrown the threshold
+     * @return true if compaction is due
+     */
+    bool needsCompaction() const;
+
+    /**
+     * @brief Close the current segment and start a new one
+     * @return Generation of the new segment, or 0 on failure
+     */
+    quint64 rotate();
+
+    /**
+     * @brief Get the journal directory
+     * @return The directory path
+     */
+    QString directory() const;
+
+    /**
+     * @brief Atomically write a base snapshot (thread-safe)
+     * @param directory The journal directory
+     * @param generation First journal segment not contained in @p values
+     * @param values The configuration to store
+     * @return true if the snapshot was committed
+     */
+    static bool writeSnapshot(const QString &directory, quint64 generation,
+                              const QHash<QString, QVariant> &values);
+
+    /**
+     * @brief Delete journal segments folded into a snapshot (thread-safe)
+     * @param directory The journal directory
+     * @param generation Segments older than this are removed
+     */
+    static void removeSegmentsBefore(const QString &directory,
+                                     quint64 generation);
+
+private:
+    enum Operation : quint8 {
+        SetOperation = 1,
+        RemoveOperation,
+        ClearOperation
+    };
+
+    bool append(Operation operation, const QString &key,
+                const QVariant &value);
+    bool openSegment(quint64 generation);
+    static QString segmentPath(const QString &directory, quint64 generation);
+    static QList<quint64> segmentGenerations(const QString &directory);
+    static bool readSnapshot(const QString &directory, quint64 *generation,
+                             QHash<QString, QVariant> *values);
+    static bool replaySegment(const QString &path, bool active,
+                              QHash<QString, QVariant> *values,
+                              bool *hadRecords);
+
+    QString m_directory;
+    QFile m_segment;
+    quint64 m_generation;
+    qint64 m_compactionThreshold;
+    bool m_empty;
+};
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <QSharedData>
+#include <QSharedDataPointer>
+#include <QString>
+#include <QStringList>
+#include <set>
+
+/**
+ * @brief Ordered index over hierarchical configuration keys
+ *
+ * Keys use '/' as group separator, as in QSettings. The index keeps keys
+ * sorted so that every key below a group forms one contiguous range;
+ * prefix queries therefore cost O(log n) to find the range plus the size
+ * of the result, independent of the total number of keys.
+ *
+ * The index is implicitly shared: copies are O(1) and share storage until
+ * one of them is modified. That first modification deep-copies the whole
+ * set, O(n) with one allocation per key, so an index that is copied into
+ * every published snapshot pays that copy once per publish cycle in
+ * which keys are added or removed. Changing the values of existing keys
+ * does not touch the index.
+ */
+class ConfigurationKeyIndex {
+public:
+    using const_iterator = std::set<QString>::const_iterator;
+
+    /**
+     * @brief Iterable range of keys, usable with range-based for loops
+     */
+    class Range {
+    public:
+        Range(const_iterator first, const_iterator last)
+            : m_first(first), m_last(last) {}
+
+        const_iterator begin() const { return m_first; }
+        const_iterator end() const { return m_last; }
+        bool isEmpty() const { return m_first == m_last; }
+
+    private:
+        const_iterator m_first;
+        const_iterator m_last;
+    };
+
+    ConfigurationKeyIndex();
+
+    /**
+     * @brief Add a key to the index
+     * @param key The configuration key
+     */
+    void insert(const QString &key);
+
+    /**
+     * @brief Remove a key from the index
+     * @param key The configuration key
+     */
+    void remove(const QString &key);
+
+    /**
+     * @brief Remove all keys
+     */
+    void clear();
+
+    /**
+     * @brief Check if a key is indexed
+     * @param key The configuration key
+     * @return true if the key exists
+     */
+    bool contains(const QString &key) const;
+
+    /**
+     * @brief Get the number of indexed keys
+     * @return The key count
+     */
+    qsizetype size() const;
+
+    /**
+     * @brief Get all keys in sorted order
+     * @return List of all keys
+     */
+    QStringList keys() const;
+
+    /**
+     * @brief Get the keys below a group, at any depth
+     * @param group The group (e.g. "window" or "window/"); empty for all keys
+     * @return Range over the matching keys, in sorted order
+     */
+    Range range(const QString &group) const;
+
+    /**
+     * @brief Get all keys below a group, at any depth
+     * @param group The group (e.g. "window" or "window/"); empty for all keys
+     * @return List of full keys, in sorted order
+     */
+    QStringList keysUnder(const QString &group) const;
+
+    /**
+     * @brief Get the names of the direct subgroups of a group
+     * @param group The parent group; empty for top-level groups
+     * @return List of subgroup names (without the parent prefix)
+     */
+    QStringList childGroups(const QString &group) const;
+
+    /**
+     * @brief Get the names of the keys directly inside a group
+     * @param group The parent group; empty for top-level keys
+     * @return List of key names (without the parent prefix)
+     */
+    QStringList childKeys(const QString &group) const;
+
+private:
+    static QString groupPrefix(const QString &group);
+    static QString groupUpperBound(const QString &prefix);
+
+    struct Data : public QSharedData {
+        std::set<QString> keys;
+    };
+
+    QSharedDataPointer<Data> d;
+};
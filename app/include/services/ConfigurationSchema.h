@@ -0,0 +1,66 @@
+#pragma once
+
+#include <QHash>
+#include <QMetaType>
+#include <QString>
+#include <QStringView>
+#include <QVariant>
+#include <string_view>
+
+/**
+ * @brief Compile-time schema of the known configuration keys
+ *
+ * Every known key has a fixed type, a default value and optionally a valid
+ * range. The schema is a sorted constexpr table, so a lookup is a binary
+ * search and nothing is parsed at runtime. Keys that are not in the schema
+ * are accepted as they are.
+ */
+class ConfigurationSchema {
+public:
+    /**
+     * @brief Description of one configuration key
+     *
+     * Numeric and boolean defaults are stored in defaultNumber, string
+     * defaults in defaultString. A range applies if minimum <= maximum.
+     */
+    struct Entry {
+        std::u16string_view key;
+        QMetaType::Type type;
+        double defaultNumber;
+        std::u16string_view defaultString;
+        double minimum;
+        double maximum;
+
+        constexpr bool hasRange() const { return minimum <= maximum; }
+    };
+
+    /**
+     * @brief Look up the schema entry of a key
+     * @param key The configuration key
+     * @return The entry, or nullptr if the key is not in the schema
+     */
+    static const Entry *find(QStringView key);
+
+    /**
+     * @brief Get the default value of a schema entry
+     * @param entry The schema entry
+     * @return The default, with the entry's type
+     */
+    static QVariant defaultValue(const Entry &entry);
+
+    /**
+     * @brief Get the defaults of all keys in the schema
+     * @return Map of key to default value
+     */
+    static QHash<QString, QVariant> defaults();
+
+    /**
+     * @brief Validate a value and convert it to the key's type
+     * @param key The configuration key
+     * @param value The value to check
+     * @param result Receives the converted value
+     * @return false if the value cannot be converted or is out of range
+     */
+    static bool normalize(const QString &key, const QVariant &value,
+                          QVariant *result);
+};
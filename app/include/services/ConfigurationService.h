@@ -1,23 +1,91 @@
 #pragma once
 
+#include <QAtomicInteger>
 #include <QHash>
+#include <QList>
+#include <QPointer>
+#include <QReadWriteLock>
 #include <QSettings>
 #include <QString>
+#include <QThreadPool>
 #include <QVariant>
+#include <array>
+#include <functional>
 #include "interfaces/IService.h"
+#include "services/ConfigurationJournal.h"
+#include "services/ConfigurationSharedLayer.h"
+#include "services/ConfigurationSnapshot.h"
+
+class QTimer;
 
 /**
  * @brief Configuration service for managing application settings
  *
  * This service provides centralized configuration management
  * with support for different configuration sources.
+ *
+ * Values come from several layers with increasing precedence: built-in
+ * defaults, a system-wide file, the active profile, the per-user settings
+ * store, environment variables and command-line overrides. The layers are
+ * merged into one flattened table, so a lookup is a single hash probe
+ * regardless of how many layers exist. When a layer changes only the keys
+ * of that layer are re-resolved. setConfiguration() and
+ * removeConfiguration() write to the user layer.
+ *
+ * Known keys are described by ConfigurationSchema, a compile-time table
+ * that supplies the defaults layer and the type and range of each key.
+ * Values for known keys are converted to the schema type when they enter
+ * any layer; setConfiguration() rejects values that do not fit.
+ *
+ * Changes to the user layer are persisted by a debounced background save:
+ * a snapshot of the layer is serialized on a worker thread and atomically
+ * replaces the settings file, so disk I/O never blocks the owner thread.
+ * Alternatively the user layer can be kept in an append-only journal (see
+ * setJournalDirectory()), which makes each write O(1) on disk.
+ *
+ * The service is owned by a single thread (the thread it lives in), which
+ * is the only thread allowed to modify configuration. Other threads read
+ * through immutable snapshots, so they never observe a partial update.
+ * Publishing swaps a single pointer; readers only hold a read lock for
+ * as long as it takes to copy that pointer, never while building or
+ * querying a snapshot.
+ * Writes made on the owner thread become visible to other threads once the
+ * owner returns to its event loop or calls publishSnapshot().
  */
 class ConfigurationService : public IService {
     Q_OBJECT
 
 public:
+    /**
+     * @brief Callback invoked for subscribed configuration changes
+     * The value is invalid when the key was removed.
+     */
+    using ChangeCallback =
+        std::function<void(const QString &key, const QVariant &value)>;
+
+    /**
+     * @brief Configuration sources, in increasing order of precedence
+     */
+    enum Layer {
+        DefaultsLayer,
+        SystemLayer,
+        ProfileLayer,
+        UserLayer,
+        EnvironmentLayer,
+        CommandLineLayer,
+        LayerCount
+    };
+    Q_ENUM(Layer)
+
     explicit ConfigurationService(QObject *parent = nullptr);
-    virtual ~ConfigurationService() = default;
+
+    /**
+     * @brief Destroy the service
+     * Changes still waiting for the debounced save are written
+     * synchronously, so destroying the service without stop() loses
+     * nothing. No signals are emitted from the destructor.
+     */
+    ~ConfigurationService() override;
 
     // IService interface implementation
     bool initialize() override;
@@ -45,7 +113,8 @@ public:
     bool hasConfiguration(const QString &key) const;
 
     /**
-     * @brief Remove a configuration key
+     * @brief Remove a configuration key from the user layer
+     * A value provided by a lower layer becomes effective again.
      * @param key The configuration key
      * @return true if the key was removed
      */
@@ -53,12 +122,76 @@ public:
 
     /**
      * @brief Get all configuration keys
-     * @return List of all configuration keys
+     * @return Sorted list of all configuration keys
      */
     QStringList getAllKeys() const;
 
     /**
-     * @brief Clear all configuration
+     * @brief Get all keys below a group, at any depth
+     * @param group The group, e.g. "window" or "window/"
+     * @return Sorted list of full keys
+     */
+    QStringList keysUnder(const QString &group) const;
+
+    /**
+     * @brief Get the direct subgroups of a group
+     * @param group The parent group; empty for top-level groups
+     * @return List of subgroup names
+     */
+    QStringList childGroups(const QString &group) const;
+
+    /**
+     * @brief Get the keys directly inside a group
+     * @param group The parent group; empty for top-level keys
+     * @return List of key names
+     */
+    QStringList childKeys(const QString &group) const;
+
+    /**
+     * @brief Get the ordered key index
+     *
+     * The returned index is an implicitly shared copy, so it can be
+     * iterated with ConfigurationKeyIndex::range() without holding on to
+     * the service.
+     *
+     * @return The key index
+     */
+    ConfigurationKeyIndex keyIndex() const;
+
+    /**
+     * @brief Subscribe to changes of a key or of a whole group
+     *
+     * A pattern ending in '/' subscribes to every key below that group at
+     * any depth; an empty pattern subscribes to all keys; anything else
+     * matches one exact key. Dispatch only reaches matching subscribers, at
+     * a cost proportional to the depth of the changed key.
+     *
+     * The callback runs in the thread of @p context: directly when that is
+     * the current thread and @p type is Qt::AutoConnection, queued
+     * otherwise. The subscription ends automatically when @p context is
+     * destroyed. Without a context the callback is scoped to the service.
+     * Must be called from the owner thread.
+     *
+     * @param pattern Exact key, group ending in '/', or empty for all keys
+     * @param context Object whose thread and lifetime scope the callback
+     * @param callback The function to call on change
+     * @param type Qt::AutoConnection, Qt::DirectConnection or
+     * Qt::QueuedConnection
+     * @return Subscription id for unsubscribe()
+     */
+    int subscribe(const QString &pattern, QObject *context,
+                  ChangeCallback callback,
+                  Qt::ConnectionType type = Qt::AutoConnection);
+
+    /**
+     * @brief Cancel a subscription
+     * @param subscriptionId The id returned by subscribe()
+     */
+    void unsubscribe(int subscriptionId);
+
+    /**
+     * @brief Clear all user configuration
+     * Values provided by the other layers remain in effect.
      */
     void clearConfiguration();
 
@@ -68,6 +201,52 @@ public:
      */
     bool saveConfiguration();
 
+    /**
+     * @brief Save configuration to persistent storage on a worker thread
+     *
+     * A snapshot of the user layer is taken immediately; serialization and
+     * disk I/O happen on a worker thread. File-based stores are written to
+     * a temporary file, synced to disk and atomically renamed over the
+     * settings file, so a crash never leaves a partially written file.
+     * Saves run one at a time; a queued save that has been superseded by a
+     * newer one is skipped and completes together with the newer one.
+     * Every call is answered by exactly one configurationSaveFinished().
+     */
+    void saveConfigurationAsync();
+
+    /**
+     * @brief Wait for outstanding asynchronous saves to finish
+     * @param msecs Maximum time to wait, or -1 to wait indefinitely
+     * @return true if no save is outstanding
+     */
+    bool waitForPendingSaves(int msecs = -1);
+
+    /**
+     * @brief Store the user layer in an append-only journal
+     *
+     * Every change appends one checksummed record instead of rewriting
+     * the settings file. When the journal outgrows the compaction
+     * threshold it is folded into a new base snapshot on a worker thread.
+     * An empty journal directory is seeded with the current user layer.
+     * Passing an empty path returns to the QSettings store.
+     *
+     * @param directory The journal directory, or empty to disable
+     * @return true if the journal was opened
+     */
+    bool setJournalDirectory(const QString &directory);
+
+    /**
+     * @brief Get the journal directory
+     * @return The directory, or an empty string if no journal is used
+     */
+    QString getJournalDirectory() const;
+
+    /**
+     * @brief Set the journal size that triggers compaction
+     * @param bytes The threshold in bytes
+     */
+    void setJournalCompactionThreshold(qint64 bytes);
+
     /**
      * @brief Load configuration from persistent storage
      * @return true if load was successful
@@ -91,6 +270,153 @@ public:
      */
     QString getConfigurationFile() const;
 
+    /**
+     * @brief Replace the contents of a configuration layer
+     *
+     * Only keys present in the old or new contents of the layer are
+     * re-resolved; change notifications are sent for keys whose effective
+     * value changed. The user layer is owned by the settings store and
+     * cannot be replaced this way. Values that violate the schema are
+     * dropped.
+     *
+     * @param layer The layer to replace
+     * @param values The new layer contents
+     * @return true if the layer was replaced
+     */
+    bool setLayer(Layer layer, const QHash<QString, QVariant> &values);
+
+    /**
+     * @brief Get the contents of a configuration layer
+     * @param layer The layer
+     * @return The values provided by that layer
+     */
+    QHash<QString, QVariant> layer(Layer layer) const;
+
+    /**
+     * @brief Get the layer that provides the effective value of a key
+     * @param key The configuration key
+     * @return The winning layer, or LayerCount if the key is not set
+     */
+    Layer effectiveLayer(const QString &key) const;
+
+    /**
+     * @brief Load the system-wide layer from an INI file
+     * @param filePath Path to the system configuration file
+     * @return true if the file exists and was loaded
+     */
+    bool loadSystemConfiguration(const QString &filePath);
+
+    /**
+     * @brief Share the parsed system layer with other instances
+     *
+     * When enabled, loadSystemConfiguration() takes the layer from shared
+     * memory if another instance already published the unchanged file,
+     * and publishes it for the others otherwise. The user layer stays
+     * private to each instance.
+     *
+     * @param enabled true to share the system layer
+     */
+    void setSystemLayerSharingEnabled(bool enabled);
+
+    /**
+     * @brief Check if the system layer is shared with other instances
+     * @return true if sharing is enabled
+     */
+    bool isSystemLayerSharingEnabled() const;
+
+    /**
+     * @brief Get the version of the shared system layer in use
+     * @return The version counter, or 0 if no shared layer is in use
+     */
+    quint64 sharedSystemLayerVersion() const;
+
+    /**
+     * @brief Parse a profile from an INI file and keep it resident
+     * @param name The profile name
+     * @param filePath Path to the profile file
+     * @return true if the file exists and was loaded
+     */
+    bool loadProfile(const QString &name, const QString &filePath);
+
+    /**
+     * @brief Add or replace a resident profile
+     * @param name The profile name
+     * @param values The profile contents
+     */
+    void addProfile(const QString &name,
+                    const QHash<QString, QVariant> &values);
+
+    /**
+     * @brief Remove a resident profile, deactivating it if it is active
+     * @param name The profile name
+     * @return true if the profile existed
+     */
+    bool removeProfile(const QString &name);
+
+    /**
+     * @brief Get the names of all resident profiles
+     * @return Sorted list of profile names
+     */
+    QStringList profiles() const;
+
+    /**
+     * @brief Switch the profile layer to a resident profile
+     *
+     * Profiles are parsed once and shared with the layer, so switching
+     * costs no parsing or copying; only keys whose effective value differs
+     * between the two profiles are re-resolved and notified.
+     *
+     * @param name The profile name, or empty to deactivate profiles
+     * @return true if the profile exists
+     */
+    bool setActiveProfile(const QString &name);
+
+    /**
+     * @brief Get the active profile
+     * @return The profile name, or an empty string if none is active
+     */
+    QString activeProfile() const;
+
+    /**
+     * @brief Load the environment layer from environment variables
+     *
+     * Every variable named <prefix><group>__<key> becomes the key
+     * "group/key"; a double underscore separates groups.
+     *
+     * @param prefix Variable name prefix, e.g. "QST_"
+     */
+    void loadEnvironment(const QString &prefix);
+
+    /**
+     * @brief Load the command-line layer from program arguments
+     *
+     * Recognizes "--config key=value" and "--config=key=value"; other
+     * arguments are ignored.
+     *
+     * @param arguments The program arguments
+     */
+    void loadCommandLine(const QStringList &arguments);
+
+    /**
+     * @brief Get the most recently published configuration snapshot
+     *
+     * Safe to call from any thread. When called from the owner thread any
+     * pending changes are published first, so the result is always current
+     * there.
+     *
+     * @return Shared pointer to an immutable snapshot (never null)
+     */
+    ConfigurationSnapshotPtr snapshot() const;
+
+    /**
+     * @brief Publish pending changes to readers on other threads
+     *
+     * Must be called from the owner thread. Changes are published
+     * automatically on the next event loop iteration; call this to make
+     * them visible immediately.
+     */
+    void publishSnapshot() const;
+
 signals:
     /**
      * @brief Emitted when configuration is loaded
@@ -102,17 +428,101 @@ signals:
      */
     void configurationSaved();
 
+    /**
+     * @brief Emitted when an asynchronous save has finished
+     * @param success true if the configuration was written
+     */
+    void configurationSaveFinished(bool success);
+
     /**
      * @brief Emitted when configuration is reset
      */
     void configurationReset();
 
+    /**
+     * @brief Emitted once when the active profile has been switched
+     * @param name The new active profile
+     * @param changedKeys Keys whose effective value changed
+     */
+    void activeProfileChanged(const QString &name,
+                              const QStringList &changedKeys);
+
 private:
     void initializeDefaults();
     void setupSettings();
+    void reloadUserLayer();
+    void markUserLayerDirty();
+    void flushPendingChanges();
+    void journalWritten(bool success);
+    void compactJournal(bool requested);
+    void startCompaction();
+    QStringList replaceLayer(Layer layer,
+                             const QHash<QString, QVariant> &values);
+    bool resolveKey(const QString &key);
+    void notifyChanges(const QStringList &keys);
+    void schedulePublish();
+    bool isOwnerThread() const;
+    void notifySubscribers(const QString &key, const QVariant &value);
+
+    struct Subscription {
+        int id;
+        QPointer<QObject> context;
+        ChangeCallback callback;
+        Qt::ConnectionType type;
+        QMetaObject::Connection destroyedConnection;
+    };
+
+    void deliver(const Subscription &subscription, const QString &key,
+                 const QVariant &value);
 
     QSettings *m_settings;
+    std::array<QHash<QString, QVariant>, LayerCount> m_layers;
+    bool m_userLayerDirty;
+    // Bumped on every user layer change, so that a finished background
+    // save only clears the dirty flag when nothing changed after it began
+    quint64 m_userLayerRevision;
+
+    // Flattened effective values of all layers
     QHash<QString, QVariant> m_cache;
+    ConfigurationKeyIndex m_keyIndex;
     QString m_configurationFile;
     bool m_running;
+
+    // Snapshot publication (RCU-style). The lock only guards the pointer
+    // itself; std::atomic<std::shared_ptr> is not available on libc++.
+    mutable QReadWriteLock m_snapshotLock;
+    mutable ConfigurationSnapshotPtr m_snapshot;
+    mutable quint64 m_snapshotVersion;
+    mutable bool m_publishPending;
+
+    // Change subscriptions, keyed by exact key or group prefix
+    QHash<QString, QList<Subscription>> m_subscriptions;
+    QHash<int, QString> m_subscriptionPatterns;
+    int m_nextSubscriptionId;
+
+    // Journaled user layer storage
+    std::unique_ptr<ConfigurationJournal> m_journal;
+    qint64 m_journalCompactionThreshold;
+    bool m_compactionRunning;
+    // A compaction is due but not started yet; compactions due while one
+    // is running are served together by one more run once it finishes.
+    // Only explicitly requested ones (saveConfigurationAsync()) are
+    // answered by configurationSaveFinished().
+    bool m_compactionPending;
+    int m_compactionRequests;
+
+    // System layer shared with other instances
+    bool m_shareSystemLayer;
+    std::unique_ptr<ConfigurationSharedLayer> m_sharedSystemLayer;
+
+    // Resident profiles; implicitly shared with the profile layer
+    QHash<QString, QHash<QString, QVariant>> m_profiles;
+    QString m_activeProfile;
+
+    // Background persistence; the pool is declared last so that it is
+    // destroyed (and waits for running saves) before anything they use
+    QTimer *m_autoSaveTimer;
+    QAtomicInteger<quint64> m_saveGeneration;
+    QAtomicInt m_supersededSaves;
+    QThreadPool m_savePool;
 };
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <QHash>
+#include <QSharedMemory>
+#include <QString>
+#include <QVariant>
+
+/**
+ * @brief Read-only configuration layer shared between application instances
+ *
+ * The first instance that parses a configuration file publishes the result
+ * into a named shared-memory segment derived from the file's path. Other
+ * instances on the same machine read the published layer instead of
+ * reading and parsing the file again. The segment records the size and
+ * modification time of the source file, so a changed file is detected and
+ * re-published with an incremented version counter.
+ *
+ * Sharing saves reading and parsing the file, not memory: QVariant values
+ * cannot be used in place, so every instance decodes its own copy of the
+ * layer from the segment.
+ *
+ * A segment cannot be resized. When a grown file no longer fits, a larger
+ * successor segment is created and the old one is marked with a link to
+ * it, which readers follow. A segment lives as long as any instance is
+ * attached to it.
+ */
+class ConfigurationSharedLayer {
+public:
+    /**
+     * @brief Size and modification time of the source file
+     * Both are -1 if the file does not exist.
+     */
+    struct SourceStamp {
+        qint64 modified = -1;
+        qint64 size = -1;
+    };
+
+    explicit ConfigurationSharedLayer(const QString &sourceFile);
+    ~ConfigurationSharedLayer();
+
+    /**
+     * @brief Read the published layer if it is up to date
+     * @param values Receives the layer contents
+     * @return true if a layer matching the source file was found
+     */
+    bool read(QHash<QString, QVariant> *values);
+
+    /**
+     * @brief Get the current stamp of the source file
+     *
+     * Take the stamp before parsing the file and pass it to publish(), so
+     * an edit made while parsing is not published under the new stamp.
+     *
+     * @return The stamp
+     */
+    SourceStamp sourceStamp() const;
+
+    /**
+     * @brief Publish a parsed layer for other instances
+     * @param values The layer contents parsed from the source file
+     * @param stamp The stamp of the source file taken before parsing it
+     * @return true if the layer was published
+     */
+    bool publish(const QHash<QString, QVariant> &values,
+                 const SourceStamp &stamp);
+
+    /**
+     * @brief Get the version of the layer last read or published
+     * @return The version counter, or 0 if nothing was read or published
+     */
+    quint64 version() const;
+
+    /**
+     * @brief Get the source file of this layer
+     * @return The file path
+     */
+    QString sourceFile() const;
+
+private:
+    bool attach();
+    bool grow(qsizetype required, quint64 *previousVersion);
+
+    QString m_sourceFile;
+    QSharedMemory m_memory;
+    quint32 m_segment;
+    quint64 m_version;
+};
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QVariant>
+#include <memory>
+#include "services/ConfigurationKeyIndex.h"
+
+/**
+ * @brief Immutable, versioned view of the configuration
+ *
+ * Snapshots are published by ConfigurationService and can be shared
+ * freely between threads. A snapshot never changes after it has been
+ * published; newer configuration is exposed through a new snapshot with
+ * a higher version number.
+ */
+class ConfigurationSnapshot {
+public:
+    ConfigurationSnapshot() = default;
+    ConfigurationSnapshot(quint64 version, QHash<QString, QVariant> values,
+                          ConfigurationKeyIndex keyIndex)
+        : m_version(version),
+          m_values(std::move(values)),
+          m_keyIndex(std::move(keyIndex)) {}
+
+    /**
+     * @brief Get the version of this snapshot
+     * @return Monotonically increasing version number
+     */
+    quint64 version() const { return m_version; }
+
+    /**
+     * @brief Get a configuration value
+     * @param key The configuration key
+     * @return The value, or an invalid QVariant if the key is absent
+     */
+    QVariant value(const QString &key) const { return m_values.value(key); }
+
+    /**
+     * @brief Get a configuration value with default
+     * @param key The configuration key
+     * @param defaultValue The value returned if the key is absent
+     * @return The value or default
+     */
+    QVariant value(const QString &key, const QVariant &defaultValue) const {
+        return m_values.value(key, defaultValue);
+    }
+
+    /**
+     * @brief Check if a configuration key exists in this snapshot
+     * @param key The configuration key
+     * @return true if the key exists
+     */
+    bool contains(const QString &key) const { return m_values.contains(key); }
+
+    /**
+     * @brief Get all keys in this snapshot
+     * @return Sorted list of configuration keys
+     */
+    QStringList keys() const { return m_keyIndex.keys(); }
+
+    /**
+     * @brief Get the ordered key index of this snapshot
+     * @return The key index, for prefix queries and range iteration
+     */
+    const ConfigurationKeyIndex &keyIndex() const { return m_keyIndex; }
+
+    /**
+     * @brief Get the number of keys in this snapshot
+     * @return The key count
+     */
+    qsizetype size() const { return m_values.size(); }
+
+private:
+    quint64 m_version = 0;
+    QHash<QString, QVariant> m_values;
+    ConfigurationKeyIndex m_keyIndex;
+};
+
+using ConfigurationSnapshotPtr = std::shared_ptr<const ConfigurationSnapshot>;
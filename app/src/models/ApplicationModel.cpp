@@ -12,76 +12,149 @@ const QString ApplicationModel::PROPERTY_IS_BUSY = "isBusy";
 const QString ApplicationModel::PROPERTY_LAST_UPDATED = "lastUpdated";
 const QString ApplicationModel::PROPERTY_USER_NAME = "userName";
 const QString ApplicationModel::PROPERTY_THEME = "theme";
-
-ApplicationModel::ApplicationModel(QObject *parent) : BaseModel(parent) {}
+const QString ApplicationModel::PROPERTY_WINDOW_TITLE = "windowTitle";
+
+namespace {
+
+// Properties stored in the "Application" settings group, under their names
+const QStringList &persistedProperties() {
+    static const QStringList properties = {ApplicationModel::PROPERTY_USER_NAME,
+                                           ApplicationModel::PROPERTY_THEME};
+    return properties;
+}
+
+}  // namespace
+
+ApplicationModel::ApplicationModel(QObject *parent)
+    : BaseModel(propertyNames(), parent) {
+    // Required properties
+    addValidator({PROPERTY_APP_NAME, PROPERTY_APP_VERSION}, [this]() {
+        return !getAppName().isEmpty() && !getAppVersion().isEmpty();
+    });
+
+    // Theme
+    addValidator({PROPERTY_THEME},
+                 [this]() { return isValidTheme(getTheme()); });
+
+    // Derived: "<name> <version> - <status>"
+    addDerivedProperty(PROPERTY_WINDOW_TITLE, [this]() {
+        QString title = getAppName();
+        const QString version = getAppVersion();
+        if (!version.isEmpty()) {
+            title += QLatin1Char(' ') + version;
+        }
+        const QString status = getStatusMessage();
+        if (!status.isEmpty()) {
+            title += QStringLiteral(" - ") + status;
+        }
+        return QVariant(title);
+    });
+
+    // Specific signals for certain properties
+    subscribe<StatusMessage>(
+        [this](const QString &message) { emit statusChanged(message); });
+    subscribe<IsBusy>([this](bool busy) { emit busyStateChanged(busy); });
+    subscribe<Theme>(
+        [this](const QString &theme) { emit themeChanged(theme); });
+}
+
+const ModelPropertyTable &ApplicationModel::propertyNames() {
+    // Must list the properties in the slot order of the ModelProperty IDs
+    static const ModelPropertyTable table = {
+        PROPERTY_APP_NAME,       PROPERTY_APP_VERSION, PROPERTY_APP_TITLE,
+        PROPERTY_STATUS_MESSAGE, PROPERTY_IS_BUSY,     PROPERTY_LAST_UPDATED,
+        PROPERTY_USER_NAME,      PROPERTY_THEME};
+    return table;
+}
 
 QString ApplicationModel::getAppName() const {
-    return getProperty(PROPERTY_APP_NAME).toString();
+    return get<AppName>();
 }
 
 QString ApplicationModel::getAppVersion() const {
-    return getProperty(PROPERTY_APP_VERSION).toString();
+    return get<AppVersion>();
 }
 
 QString ApplicationModel::getAppTitle() const {
-    return getProperty(PROPERTY_APP_TITLE).toString();
+    return get<AppTitle>();
 }
 
 QString ApplicationModel::getStatusMessage() const {
-    return getProperty(PROPERTY_STATUS_MESSAGE).toString();
+    return get<StatusMessage>();
 }
 
 bool ApplicationModel::isBusy() const {
-    return getProperty(PROPERTY_IS_BUSY).toBool();
+    return get<IsBusy>();
 }
 
 QDateTime ApplicationModel::getLastUpdated() const {
-    return getProperty(PROPERTY_LAST_UPDATED).toDateTime();
+    return get<LastUpdated>();
 }
 
 QString ApplicationModel::getUserName() const {
-    return getProperty(PROPERTY_USER_NAME).toString();
+    return get<UserName>();
 }
 
 QString ApplicationModel::getTheme() const {
-    return getProperty(PROPERTY_THEME).toString();
+    return get<Theme>();
+}
+
+QString ApplicationModel::getWindowTitle() const {
+    return getProperty(PROPERTY_WINDOW_TITLE).toString();
 }
 
 void ApplicationModel::setAppName(const QString &name) {
-    setProperty(PROPERTY_APP_NAME, name);
+    set<AppName>(name);
 }
 
 void ApplicationModel::setAppVersion(const QString &version) {
-    setProperty(PROPERTY_APP_VERSION, version);
+    set<AppVersion>(version);
 }
 
 void ApplicationModel::setAppTitle(const QString &title) {
-    setProperty(PROPERTY_APP_TITLE, title);
+    set<AppTitle>(title);
 }
 
 void ApplicationModel::setStatusMessage(const QString &message) {
-    setProperty(PROPERTY_STATUS_MESSAGE, message);
+    set<StatusMessage>(message);
 }
 
 void ApplicationModel::setBusy(bool busy) {
-    setProperty(PROPERTY_IS_BUSY, busy);
+    set<IsBusy>(busy);
 }
 
 void ApplicationModel::setLastUpdated(const QDateTime &dateTime) {
-    setProperty(PROPERTY_LAST_UPDATED, dateTime);
+    set<LastUpdated>(dateTime);
 }
 
 void ApplicationModel::setUserName(const QString &userName) {
-    setProperty(PROPERTY_USER_NAME, userName);
+    set<UserName>(userName);
 }
 
 void ApplicationModel::setTheme(const QString &theme) {
-    setProperty(PROPERTY_THEME, theme);
+    set<Theme>(theme);
 }
 
 void ApplicationModel::updateStatus(const QString &message) {
-    setStatusMessage(message);
-    setLastUpdated(QDateTime::currentDateTime());
+    {
+        QMutexLocker locker(&m_statusHistoryMutex);
+        m_statusHistory.record(message, QDateTime::currentMSecsSinceEpoch());
+    }
+
+    // One change set, so views update once per status change
+    applyUpdate(PropertyUpdate()
+                    .set<StatusMessage>(message)
+                    .set<LastUpdated>(QDateTime::currentDateTime()));
+}
+
+QList<StatusHistory::Entry> ApplicationModel::getStatusHistory() const {
+    QMutexLocker locker(&m_statusHistoryMutex);
+    return m_statusHistory.entries();
+}
+
+void ApplicationModel::setStatusHistoryCapacity(int capacity) {
+    QMutexLocker locker(&m_statusHistoryMutex);
+    m_statusHistory.setCapacity(capacity);
 }
 
 void ApplicationModel::clearStatus() { setStatusMessage(QString()); }
@@ -90,23 +163,47 @@ bool ApplicationModel::loadSettings() {
     QSettings settings;
 
     settings.beginGroup("Application");
-    setUserName(settings.value("userName", QString()).toString());
-    setTheme(settings.value("theme", "default").toString());
+    const QString userName = settings.value("userName", QString()).toString();
+    const QString theme = settings.value("theme", "default").toString();
     settings.endGroup();
 
+    applyUpdate(PropertyUpdate().set<UserName>(userName).set<Theme>(theme));
+
+    // Only properties that now match the store are clean; a vetoed value
+    // (an unknown theme, say) stays dirty so the next save replaces it
+    QStringList applied;
+    if (get<UserName>() == userName) {
+        applied.append(PROPERTY_USER_NAME);
+    }
+    if (get<Theme>() == theme) {
+        applied.append(PROPERTY_THEME);
+    }
+    takeDirty(applied);
+
     emit settingsLoaded();
     return true;
 }
 
 bool ApplicationModel::saveSettings() {
-    QSettings settings;
-
-    settings.beginGroup("Application");
-    settings.setValue("userName", getUserName());
-    settings.setValue("theme", getTheme());
-    settings.endGroup();
-
-    settings.sync();
+    // Only what changed since the last load or save is written; with
+    // nothing changed there is no settings I/O at all
+    const QStringList changed = takeDirty(persistedProperties());
+    if (!changed.isEmpty()) {
+        QSettings settings;
+
+        settings.beginGroup("Application");
+        for (const QString &propertyName : changed) {
+            settings.setValue(propertyName, getProperty(propertyName));
+        }
+        settings.endGroup();
+
+        settings.sync();
+        if (settings.status() != QSettings::NoError) {
+            // Nothing was persisted; the next save has to try again
+            markDirty(changed);
+            return false;
+        }
+    }
 
     emit settingsSaved();
     return true;
@@ -117,20 +214,6 @@ bool ApplicationModel::initializeModel() {
     return true;
 }
 
-bool ApplicationModel::validateModel() const {
-    // Check required properties
-    if (getAppName().isEmpty() || getAppVersion().isEmpty()) {
-        return false;
-    }
-
-    // Validate theme
-    if (!isValidTheme(getTheme())) {
-        return false;
-    }
-
-    return true;
-}
-
 void ApplicationModel::resetModel() { initializeDefaults(); }
 
 bool ApplicationModel::beforePropertySet(const QString &propertyName,
@@ -143,23 +226,6 @@ bool ApplicationModel::beforePropertySet(const QString &propertyName,
     return BaseModel::beforePropertySet(propertyName, value);
 }
 
-void ApplicationModel::afterPropertySet(const QString &propertyName,
-                                        const QVariant &oldValue,
-                                        const QVariant &newValue) {
-    Q_UNUSED(oldValue)
-
-    // Emit specific signals for certain properties
-    if (propertyName == PROPERTY_STATUS_MESSAGE) {
-        emit statusChanged(newValue.toString());
-    } else if (propertyName == PROPERTY_IS_BUSY) {
-        emit busyStateChanged(newValue.toBool());
-    } else if (propertyName == PROPERTY_THEME) {
-        emit themeChanged(newValue.toString());
-    }
-
-    BaseModel::afterPropertySet(propertyName, oldValue, newValue);
-}
-
 void ApplicationModel::initializeDefaults() {
     setPropertySilent(PROPERTY_APP_NAME, QCoreApplication::applicationName());
     setPropertySilent(PROPERTY_APP_VERSION,
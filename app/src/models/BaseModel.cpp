@@ -1,86 +1,319 @@
 #include "models/BaseModel.h"
 #include <QDebug>
-#include <QMutexLocker>
+#include <QTimer>
+#include "models/ModelRecorder.h"
 
-BaseModel::BaseModel(QObject *parent) : IModel(parent), m_initialized(false) {}
+namespace {
 
-bool BaseModel::initialize() {
-    QMutexLocker locker(&m_mutex);
+constexpr int kDefaultMailboxInterval = 16;  // One frame at 60 Hz
+
+const ModelPropertyTable &emptyPropertyTable() {
+    static const ModelPropertyTable table;
+    return table;
+}
+
+// Names of the properties read by the derived property being computed on
+// this thread, and the model it belongs to
+thread_local QSet<QString> *t_trackedReads = nullptr;
+thread_local const BaseModel *t_trackedModel = nullptr;
+
+}  // namespace
+
+BaseModel::BaseModel(QObject *parent)
+    : BaseModel(emptyPropertyTable(), parent) {}
+
+BaseModel::BaseModel(const ModelPropertyTable &table, QObject *parent)
+    : IModel(parent),
+      m_table(&table),
+      m_values(table.size()),
+      m_initialized(false),
+      m_version(1),
+      m_dirtySlots(table.size()),
+      m_undoEnabled(false),
+      m_subscribers(table.size()),
+      m_nextSubscriptionId(1),
+      m_recorder(nullptr),
+      m_mailboxTimer(nullptr),
+      m_mailboxInterval(kDefaultMailboxInterval),
+      m_staleValidators(0),
+      m_failingValidators(0),
+      m_lastValidity(false),
+      m_derivedCheckQueued(false) {}
 
-    if (m_initialized) {
-        return true;
+bool BaseModel::initialize() {
+    {
+        QReadLocker locker(&m_lock);
+        if (m_initialized) {
+            return true;
+        }
     }
 
-    // Initialize base properties
+    // The hooks below access properties, which take the lock themselves
     clearProperties();
 
     // Call derived class initialization
     bool result = initializeModel();
 
     if (result) {
-        m_initialized = true;
+        {
+            QWriteLocker locker(&m_lock);
+            m_initialized = true;
+        }
         emit dataChanged();
-        emit validityChanged(isValid());
+        updateValidity();
     }
 
     return result;
 }
 
 bool BaseModel::isValid() const {
-    QMutexLocker locker(&m_mutex);
-    return m_initialized && validateModel();
+    {
+        QReadLocker locker(&m_lock);
+        if (!m_initialized) {
+            return false;
+        }
+    }
+
+    // Nothing to re-run: the cached results answer without taking the
+    // mutex, so concurrent readers do not serialize on it
+    if (m_staleValidators.loadAcquire() > 0) {
+        // Re-run only the checks whose dependencies changed since last time
+        QMutexLocker locker(&m_validationMutex);
+        if (m_staleValidators.loadRelaxed() > 0) {
+            int failing = m_failingValidators.loadRelaxed();
+            for (Validator &validator : m_validators) {
+                if (!validator.stale) {
+                    continue;
+                }
+                const bool valid = validator.check();
+                if (valid != validator.valid) {
+                    failing += valid ? -1 : 1;
+                    validator.valid = valid;
+                }
+                validator.stale = false;
+            }
+            m_failingValidators.storeRelease(failing);
+            m_staleValidators.storeRelease(0);
+        }
+    }
+
+    if (m_failingValidators.loadAcquire() > 0) {
+        return false;
+    }
+
+    // validateModel() reads properties, which take the lock themselves
+    return validateModel();
 }
 
 QVariant BaseModel::getProperty(const QString &propertyName) const {
-    QMutexLocker locker(&m_mutex);
-    return m_properties.value(propertyName);
+    const int slot = m_table->slot(propertyName);
+    if (slot >= 0) {
+        return getProperty(slot);
+    }
+
+    if (t_trackedModel == this) {
+        t_trackedReads->insert(propertyName);
+    }
+
+    int derived = -1;
+    {
+        QReadLocker locker(&m_lock);
+        derived = m_derivedIndex.value(propertyName, -1);
+        if (derived < 0) {
+            return m_properties.value(propertyName);
+        }
+    }
+    return derivedValue(derived);
 }
 
 bool BaseModel::setProperty(const QString &propertyName,
                             const QVariant &value) {
-    QMutexLocker locker(&m_mutex);
+    return applyUpdate(PropertyUpdate().set(propertyName, value));
+}
+
+QVariant BaseModel::getProperty(int slot) const {
+    Q_ASSERT_X(slot >= 0 && slot < m_values.size(), "BaseModel::getProperty",
+               "undeclared property slot");
+
+    if (t_trackedModel == this) {
+        t_trackedReads->insert(m_table->name(slot));
+    }
+
+    QReadLocker locker(&m_lock);
+    return m_values.value(slot);
+}
+
+bool BaseModel::setProperty(int slot, const QVariant &value) {
+    Q_ASSERT_X(slot >= 0 && slot < m_values.size(), "BaseModel::setProperty",
+               "undeclared property slot");
+
+    return applyUpdate(PropertyUpdate().set(slot, value));
+}
 
-    // Check if we should set this property
-    if (!beforePropertySet(propertyName, value)) {
+const ModelPropertyTable &BaseModel::propertyTable() const { return *m_table; }
+
+ModelSnapshot BaseModel::snapshot() const {
+    QReadLocker locker(&m_lock);
+    return ModelSnapshot(m_table, m_values, m_properties,
+                         m_version.loadRelaxed());
+}
+
+quint64 BaseModel::version() const { return m_version.loadAcquire(); }
+
+void BaseModel::postProperty(const QString &propertyName,
+                             const QVariant &value) {
+    postEntry(-1, propertyName, value);
+}
+
+void BaseModel::postProperty(int slot, const QVariant &value) {
+    // The table is immutable; m_values may be changing on the owner thread
+    Q_ASSERT_X(slot >= 0 && slot < m_table->size(), "BaseModel::postProperty",
+               "undeclared property slot");
+
+    postEntry(slot, QString(), value);
+}
+
+void BaseModel::setMailboxInterval(int msecs) {
+    m_mailboxInterval = msecs;
+    if (m_mailboxTimer) {
+        m_mailboxTimer->setInterval(msecs);
+    }
+}
+
+bool BaseModel::drainMailbox() {
+    const PropertyUpdate update = m_mailbox.take();
+    if (update.isEmpty()) {
         return false;
     }
 
-    QVariant oldValue = m_properties.value(propertyName);
+    applyUpdate(update);
+    return true;
+}
 
-    // Only proceed if the value actually changed
-    if (oldValue == value) {
-        return true;
+void BaseModel::postEntry(int slot, const QString &propertyName,
+                          const QVariant &value) {
+    // Only the first value after a drain needs to wake the model thread
+    if (m_mailbox.post(slot, propertyName, value)) {
+        QMetaObject::invokeMethod(
+            this, [this]() { scheduleMailboxDrain(); }, Qt::QueuedConnection);
     }
+}
 
-    m_properties[propertyName] = value;
+void BaseModel::scheduleMailboxDrain() {
+    // Created here so that the timer lives in the model's thread
+    if (!m_mailboxTimer) {
+        m_mailboxTimer = new QTimer(this);
+        m_mailboxTimer->setSingleShot(true);
+        m_mailboxTimer->setInterval(m_mailboxInterval);
+        connect(m_mailboxTimer, &QTimer::timeout, this,
+                &BaseModel::drainMailbox);
+    }
 
-    // Unlock before emitting signals to avoid deadlock
-    locker.unlock();
+    if (!m_mailboxTimer->isActive()) {
+        m_mailboxTimer->start();
+    }
+}
 
-    // Call post-processing
-    afterPropertySet(propertyName, oldValue, value);
+void BaseModel::setRecorder(ModelRecorder *recorder) {
+    QWriteLocker locker(&m_lock);
+    m_recorder = recorder;
+}
 
-    // Emit signals
-    emit propertyChanged(propertyName, value);
-    emit dataChanged();
+void BaseModel::unsubscribe(int subscriptionId) {
+    QWriteLocker locker(&m_lock);
+    for (QList<Subscriber> &subscribers : m_subscribers) {
+        for (qsizetype i = 0; i < subscribers.size(); ++i) {
+            if (subscribers.at(i).id == subscriptionId) {
+                subscribers.removeAt(i);
+                return;
+            }
+        }
+    }
+}
 
-    // Check if validity changed
-    bool currentValidity = isValid();
-    emit validityChanged(currentValidity);
+int BaseModel::addSubscriber(int slot,
+                             std::function<void(const QVariant &)> deliver) {
+    Q_ASSERT_X(slot >= 0 && slot < m_subscribers.size(),
+               "BaseModel::subscribe", "undeclared property slot");
 
-    return true;
+    QWriteLocker locker(&m_lock);
+    const int id = m_nextSubscriptionId++;
+    m_subscribers[slot].append({id, std::move(deliver)});
+    return id;
 }
 
-void BaseModel::reset() {
-    QMutexLocker locker(&m_mutex);
+bool BaseModel::isDirty() const {
+    QReadLocker locker(&m_lock);
+    return !m_dirtyProperties.isEmpty() || m_dirtySlots.count(true) > 0;
+}
 
+bool BaseModel::isDirty(const QString &propertyName) const {
+    const int slot = m_table->slot(propertyName);
+
+    QReadLocker locker(&m_lock);
+    if (slot >= 0) {
+        return m_dirtySlots.testBit(slot);
+    }
+    return m_dirtyProperties.contains(propertyName);
+}
+
+QStringList BaseModel::dirtyPropertyNames() const {
+    QReadLocker locker(&m_lock);
+
+    QStringList names;
+    for (int slot = 0; slot < m_dirtySlots.size(); ++slot) {
+        if (m_dirtySlots.testBit(slot)) {
+            names.append(m_table->name(slot));
+        }
+    }
+    for (const QString &propertyName : m_dirtyProperties) {
+        names.append(propertyName);
+    }
+    return names;
+}
+
+QStringList BaseModel::takeDirty(const QStringList &propertyNames) {
+    QWriteLocker locker(&m_lock);
+
+    QStringList dirty;
+    for (const QString &propertyName : propertyNames) {
+        const int slot = m_table->slot(propertyName);
+        if (slot >= 0) {
+            if (m_dirtySlots.testBit(slot)) {
+                m_dirtySlots.clearBit(slot);
+                dirty.append(propertyName);
+            }
+        } else if (m_dirtyProperties.remove(propertyName)) {
+            dirty.append(propertyName);
+        }
+    }
+    return dirty;
+}
+
+void BaseModel::markDirty(const QStringList &propertyNames) {
+    QWriteLocker locker(&m_lock);
+    for (const QString &propertyName : propertyNames) {
+        const int slot = m_table->slot(propertyName);
+        if (slot >= 0) {
+            m_dirtySlots.setBit(slot);
+        } else {
+            m_dirtyProperties.insert(propertyName);
+        }
+    }
+}
+
+void BaseModel::clearDirty() {
+    QWriteLocker locker(&m_lock);
+    m_dirtySlots.fill(false);
+    m_dirtyProperties.clear();
+}
+
+void BaseModel::reset() {
     clearProperties();
     resetModel();
 
-    locker.unlock();
-
     emit dataChanged();
-    emit validityChanged(isValid());
+    updateValidity();
 }
 
 bool BaseModel::initializeModel() {
@@ -114,19 +347,537 @@ void BaseModel::afterPropertySet(const QString &propertyName,
     // Default implementation - override in derived classes
 }
 
+void BaseModel::addValidator(const QStringList &dependencies,
+                             std::function<bool()> check) {
+    QMutexLocker locker(&m_validationMutex);
+
+    const int index = int(m_validators.size());
+    m_validators.append({std::move(check), true, true});
+    m_staleValidators.ref();
+    for (const QString &propertyName : dependencies) {
+        m_validatorsByProperty[propertyName].append(index);
+    }
+}
+
+void BaseModel::addDerivedProperty(const QString &propertyName,
+                                   std::function<QVariant()> compute) {
+    Q_ASSERT_X(m_table->slot(propertyName) < 0, "BaseModel::addDerivedProperty",
+               "name of a declared property");
+
+    QMutexLocker locker(&m_derivedMutex);
+    m_derived.append({propertyName, std::move(compute), QVariant(),
+                      QSet<QString>(), false, false});
+
+    QWriteLocker cacheLocker(&m_lock);
+    Q_ASSERT_X(!m_derivedIndex.contains(propertyName),
+               "BaseModel::addDerivedProperty", "duplicate derived property");
+    m_derivedIndex.insert(propertyName, int(m_derivedCache.size()));
+    m_derivedCache.append({QVariant(), true});
+}
+
 void BaseModel::setPropertySilent(const QString &propertyName,
                                   const QVariant &value) {
-    m_properties[propertyName] = value;
+    {
+        QWriteLocker locker(&m_lock);
+        storeProperty(m_table->slot(propertyName), propertyName, value);
+    }
+    invalidateValidators(QStringList(propertyName));
+    invalidateDerived(QStringList(propertyName));
 }
 
 bool BaseModel::hasProperty(const QString &propertyName) const {
-    QMutexLocker locker(&m_mutex);
+    const int slot = m_table->slot(propertyName);
+
+    QReadLocker locker(&m_lock);
+    if (slot >= 0) {
+        return m_values.at(slot).isValid();
+    }
     return m_properties.contains(propertyName);
 }
 
 QStringList BaseModel::getPropertyNames() const {
-    QMutexLocker locker(&m_mutex);
-    return m_properties.keys();
+    QReadLocker locker(&m_lock);
+
+    QStringList names;
+    names.reserve(m_values.size() + m_properties.size());
+    for (int slot = 0; slot < m_values.size(); ++slot) {
+        if (m_values.at(slot).isValid()) {
+            names.append(m_table->name(slot));
+        }
+    }
+    for (auto it = m_properties.constBegin(); it != m_properties.constEnd();
+         ++it) {
+        names.append(it.key());
+    }
+    return names;
+}
+
+void BaseModel::clearProperties() {
+    {
+        QWriteLocker locker(&m_lock);
+
+        // Removing a value is a change that persistence has to see
+        m_dirtySlots.fill(true);
+        for (auto it = m_properties.constBegin(); it != m_properties.constEnd();
+             ++it) {
+            m_dirtyProperties.insert(it.key());
+        }
+
+        m_values.fill(QVariant());
+        m_properties.clear();
+        m_version.fetchAndAddRelease(1);
+
+        // The history refers to values that no longer exist
+        m_journal.clear();
+    }
+    invalidateAllValidators();
+    invalidateAllDerived();
+}
+
+bool BaseModel::applyUpdate(const PropertyUpdate &update) {
+    return commitUpdate(update, true);
+}
+
+void BaseModel::setUndoEnabled(bool enabled) {
+    QWriteLocker locker(&m_lock);
+    m_undoEnabled = enabled;
+    if (!enabled) {
+        m_journal.clear();
+    }
 }
 
-void BaseModel::clearProperties() { m_properties.clear(); }
+bool BaseModel::isUndoEnabled() const {
+    QReadLocker locker(&m_lock);
+    return m_undoEnabled;
+}
+
+bool BaseModel::undo() {
+    ModelChangeJournal::Step step;
+    {
+        QWriteLocker locker(&m_lock);
+        step = m_journal.takeUndo();
+    }
+    if (step.isEmpty()) {
+        return false;
+    }
+
+    PropertyUpdate update;
+    update.reserve(step.size());
+    for (const PropertyChange &change : std::as_const(step)) {
+        if (change.slot >= 0) {
+            update.set(change.slot, change.oldValue);
+        } else {
+            update.set(change.name, change.oldValue);
+        }
+    }
+
+    // A vetoed value would leave the history out of step with the model
+    if (!commitUpdate(update, false, AllOrNothing)) {
+        QWriteLocker locker(&m_lock);
+        m_journal.restoreUndo();
+        return false;
+    }
+    return true;
+}
+
+bool BaseModel::redo() {
+    ModelChangeJournal::Step step;
+    {
+        QWriteLocker locker(&m_lock);
+        step = m_journal.takeRedo();
+    }
+    if (step.isEmpty()) {
+        return false;
+    }
+
+    PropertyUpdate update;
+    update.reserve(step.size());
+    for (const PropertyChange &change : std::as_const(step)) {
+        if (change.slot >= 0) {
+            update.set(change.slot, change.newValue);
+        } else {
+            update.set(change.name, change.newValue);
+        }
+    }
+
+    // A vetoed value would leave the history out of step with the model
+    if (!commitUpdate(update, false, AllOrNothing)) {
+        QWriteLocker locker(&m_lock);
+        m_journal.restoreRedo();
+        return false;
+    }
+    return true;
+}
+
+bool BaseModel::canUndo() const {
+    QReadLocker locker(&m_lock);
+    return m_journal.canUndo();
+}
+
+bool BaseModel::canRedo() const {
+    QReadLocker locker(&m_lock);
+    return m_journal.canRedo();
+}
+
+void BaseModel::clearUndoHistory() {
+    QWriteLocker locker(&m_lock);
+    m_journal.clear();
+}
+
+void BaseModel::setUndoMemoryLimit(qint64 bytes) {
+    QWriteLocker locker(&m_lock);
+    m_journal.setMemoryLimit(bytes);
+}
+
+void BaseModel::setUndoMergeInterval(qint64 msecs) {
+    QWriteLocker locker(&m_lock);
+    m_journal.setMergeInterval(msecs);
+}
+
+bool BaseModel::setProperties(const QVariantHash &values) {
+    PropertyUpdate update;
+    update.reserve(values.size());
+    for (auto it = values.constBegin(); it != values.constEnd(); ++it) {
+        update.set(it.key(), it.value());
+    }
+    return commitUpdate(update, true, AllOrNothing);
+}
+
+bool BaseModel::commitUpdate(const PropertyUpdate &update, bool record,
+                             CommitMode mode) {
+    // Resolve names and let the hooks veto changes before taking the lock
+    QList<PropertyUpdate::Entry> accepted;
+    accepted.reserve(update.entries().size());
+    bool allAccepted = true;
+    for (const PropertyUpdate::Entry &entry : update.entries()) {
+        PropertyUpdate::Entry resolved = entry;
+        if (resolved.slot >= 0) {
+            Q_ASSERT_X(resolved.slot < m_values.size(),
+                       "BaseModel::applyUpdate", "undeclared property slot");
+            resolved.name = m_table->name(resolved.slot);
+        } else {
+            resolved.slot = m_table->slot(resolved.name);
+
+            if (derivedIndex(resolved.name) >= 0) {
+                qWarning() << "Cannot set derived property" << resolved.name;
+                allAccepted = false;
+                continue;
+            }
+        }
+
+        if (!beforePropertySet(resolved.name, resolved.value)) {
+            allAccepted = false;
+            continue;
+        }
+        accepted.append(resolved);
+    }
+
+    if (!allAccepted && mode == AllOrNothing) {
+        return false;
+    }
+
+    QList<PropertyChange> changes;
+    changes.reserve(accepted.size());
+    {
+        QWriteLocker locker(&m_lock);
+
+        // A property changed twice in one batch is reported once
+        const bool mayRepeat = accepted.size() > 1;
+        QHash<QString, qsizetype> changeIndex;
+        for (const PropertyUpdate::Entry &entry : accepted) {
+            const QVariant oldValue = entry.slot >= 0
+                                          ? m_values.at(entry.slot)
+                                          : m_properties.value(entry.name);
+
+            // Only proceed if the value actually changed
+            if (oldValue == entry.value) {
+                continue;
+            }
+
+            storeProperty(entry.slot, entry.name, entry.value);
+
+            if (mayRepeat) {
+                auto existing = changeIndex.constFind(entry.name);
+                if (existing != changeIndex.constEnd()) {
+                    changes[existing.value()].newValue = entry.value;
+                    continue;
+                }
+                changeIndex.insert(entry.name, changes.size());
+            }
+            changes.append({entry.slot, entry.name, oldValue, entry.value});
+        }
+
+        // Recorded under the lock so history order matches store order
+        if (record && m_undoEnabled) {
+            m_journal.record(changes);
+        }
+    }
+
+    // Signals are emitted after unlocking to avoid deadlock
+    notifyChanges(changes);
+    return allAccepted;
+}
+
+void BaseModel::notifyChanges(const QList<PropertyChange> &changes) {
+    if (changes.isEmpty()) {
+        return;
+    }
+
+    ModelRecorder *recorder = nullptr;
+    {
+        QReadLocker locker(&m_lock);
+        recorder = m_recorder;
+    }
+    if (recorder) {
+        recorder->record(changes);
+    }
+
+    QStringList names;
+    names.reserve(changes.size());
+    for (const PropertyChange &change : changes) {
+        names.append(change.name);
+    }
+
+    // Handlers below may call isValid() or read derived properties; both
+    // must already reflect the change
+    invalidateValidators(names);
+    invalidateDerived(names);
+
+    for (const PropertyChange &change : changes) {
+        // Call post-processing
+        afterPropertySet(change.name, change.oldValue, change.newValue);
+
+        if (change.slot >= 0) {
+            QList<Subscriber> subscribers;
+            {
+                QReadLocker locker(&m_lock);
+                subscribers = m_subscribers.at(change.slot);
+            }
+            for (const Subscriber &subscriber : std::as_const(subscribers)) {
+                subscriber.deliver(change.newValue);
+            }
+        }
+
+        emit propertyChanged(change.name, change.newValue);
+    }
+
+    // One notification for the whole change set
+    emit propertiesChanged(names);
+    emit dataChanged();
+
+    // Check if validity changed
+    updateValidity();
+}
+
+int BaseModel::derivedIndex(const QString &propertyName) const {
+    QReadLocker locker(&m_lock);
+    return m_derivedIndex.value(propertyName, -1);
+}
+
+QVariant BaseModel::derivedValue(int index) const {
+    // A cached value is read under the shared lock like any property
+    {
+        QReadLocker locker(&m_lock);
+        const DerivedCache &cache = m_derivedCache.at(index);
+        if (!cache.stale) {
+            return cache.value;
+        }
+    }
+
+    // Computing is serialized; another thread may have done it meanwhile
+    QMutexLocker locker(&m_derivedMutex);
+    {
+        QReadLocker cacheLocker(&m_lock);
+        const DerivedCache &cache = m_derivedCache.at(index);
+        if (!cache.stale) {
+            return cache.value;
+        }
+    }
+
+    // Record what the function reads; nested derived properties install
+    // their own tracker and restore this one
+    QSet<QString> reads;
+    QSet<QString> *outerReads = t_trackedReads;
+    const BaseModel *outerModel = t_trackedModel;
+    t_trackedReads = &reads;
+    t_trackedModel = this;
+    const QVariant value = m_derived.at(index).compute();
+    t_trackedReads = outerReads;
+    t_trackedModel = outerModel;
+
+    DerivedProperty &derived = m_derived[index];
+    for (const QString &dependency : std::as_const(derived.dependencies)) {
+        if (!reads.contains(dependency)) {
+            m_derivedByDependency[dependency].remove(index);
+        }
+    }
+    for (const QString &dependency : std::as_const(reads)) {
+        m_derivedByDependency[dependency].insert(index);
+    }
+    derived.dependencies = reads;
+
+    // Invalidation holds m_derivedMutex too, so it cannot slip in between
+    // computing and storing
+    {
+        QWriteLocker cacheLocker(&m_lock);
+        m_derivedCache[index] = {value, false};
+    }
+
+    // The first value is the baseline later changes are reported against
+    if (!derived.evaluated) {
+        derived.notifiedValue = value;
+        derived.evaluated = true;
+    }
+    return value;
+}
+
+void BaseModel::invalidateDerived(const QStringList &propertyNames) {
+    QMutexLocker locker(&m_derivedMutex);
+    if (m_derivedByDependency.isEmpty()) {
+        return;
+    }
+
+    // Derived properties may depend on each other; follow the chain
+    QWriteLocker cacheLocker(&m_lock);
+    bool invalidated = false;
+    QStringList pending = propertyNames;
+    while (!pending.isEmpty()) {
+        auto it = m_derivedByDependency.constFind(pending.takeLast());
+        if (it == m_derivedByDependency.constEnd()) {
+            continue;
+        }
+        for (int index : it.value()) {
+            DerivedProperty &derived = m_derived[index];
+            DerivedCache &cache = m_derivedCache[index];
+            if (!cache.stale) {
+                cache.stale = true;
+                pending.append(derived.name);
+            }
+            derived.pendingCheck = true;
+            invalidated = true;
+        }
+    }
+    cacheLocker.unlock();
+
+    if (invalidated) {
+        queueDerivedCheck();
+    }
+}
+
+void BaseModel::invalidateAllDerived() {
+    QMutexLocker locker(&m_derivedMutex);
+    if (m_derived.isEmpty()) {
+        return;
+    }
+
+    for (DerivedProperty &derived : m_derived) {
+        derived.pendingCheck = true;
+    }
+    {
+        QWriteLocker cacheLocker(&m_lock);
+        for (DerivedCache &cache : m_derivedCache) {
+            cache.stale = true;
+        }
+    }
+    queueDerivedCheck();
+}
+
+void BaseModel::queueDerivedCheck() {
+    // Many input changes in one event loop iteration cost one check
+    if (!m_derivedCheckQueued) {
+        m_derivedCheckQueued = true;
+        QMetaObject::invokeMethod(
+            this, [this]() { checkDerivedProperties(); },
+            Qt::QueuedConnection);
+    }
+}
+
+void BaseModel::checkDerivedProperties() {
+    QStringList names;
+    QVariantList values;
+    {
+        QMutexLocker locker(&m_derivedMutex);
+        m_derivedCheckQueued = false;
+
+        for (int index = 0; index < m_derived.size(); ++index) {
+            if (!m_derived.at(index).pendingCheck) {
+                continue;
+            }
+            m_derived[index].pendingCheck = false;
+
+            const QVariant value = derivedValue(index);
+            DerivedProperty &derived = m_derived[index];
+            if (value != derived.notifiedValue) {
+                derived.notifiedValue = value;
+                names.append(derived.name);
+                values.append(value);
+            }
+        }
+    }
+
+    if (names.isEmpty()) {
+        return;
+    }
+
+    invalidateValidators(names);
+    for (qsizetype i = 0; i < names.size(); ++i) {
+        emit propertyChanged(names.at(i), values.at(i));
+    }
+    emit propertiesChanged(names);
+
+    updateValidity();
+}
+
+void BaseModel::invalidateValidators(const QStringList &propertyNames) {
+    QMutexLocker locker(&m_validationMutex);
+    if (m_validatorsByProperty.isEmpty()) {
+        return;
+    }
+
+    for (const QString &propertyName : propertyNames) {
+        auto it = m_validatorsByProperty.constFind(propertyName);
+        if (it == m_validatorsByProperty.constEnd()) {
+            continue;
+        }
+        for (int index : it.value()) {
+            if (!m_validators[index].stale) {
+                m_validators[index].stale = true;
+                m_staleValidators.ref();
+            }
+        }
+    }
+}
+
+void BaseModel::invalidateAllValidators() {
+    QMutexLocker locker(&m_validationMutex);
+    for (Validator &validator : m_validators) {
+        validator.stale = true;
+    }
+    m_staleValidators.storeRelease(int(m_validators.size()));
+}
+
+void BaseModel::updateValidity() {
+    const bool valid = isValid();
+    {
+        QMutexLocker locker(&m_validationMutex);
+        if (valid == m_lastValidity) {
+            return;
+        }
+        m_lastValidity = valid;
+    }
+
+    // Only real transitions are announced
+    emit validityChanged(valid);
+}
+
+void BaseModel::storeProperty(int slot, const QString &propertyName,
+                              const QVariant &value) {
+    if (slot >= 0) {
+        m_values[slot] = value;
+        m_dirtySlots.setBit(slot);
+    } else {
+        m_properties[propertyName] = value;
+        m_dirtyProperties.insert(propertyName);
+    }
+    m_version.fetchAndAddRelease(1);
+}
@@ -0,0 +1,203 @@
+#include "models/ModelChangeJournal.h"
+#include <QByteArray>
+#include <QStringList>
+#include <utility>
+
+namespace {
+
+qint64 stringSize(const QString &string) {
+    return string.size() * qint64(sizeof(QChar));
+}
+
+qint64 valueSize(const QVariant &value) {
+    // Payloads that grow with their content, containers included, are
+    // estimated recursively; everything else is counted as the size of
+    // the variant itself
+    qint64 size = sizeof(QVariant);
+    switch (value.typeId()) {
+    case QMetaType::QString:
+        size += stringSize(*static_cast<const QString *>(value.constData()));
+        break;
+    case QMetaType::QByteArray:
+        size += static_cast<const QByteArray *>(value.constData())->size();
+        break;
+    case QMetaType::QStringList: {
+        const auto *list = static_cast<const QStringList *>(value.constData());
+        for (const QString &string : *list) {
+            size += sizeof(QString) + stringSize(string);
+        }
+        break;
+    }
+    case QMetaType::QVariantList: {
+        const auto *list =
+            static_cast<const QVariantList *>(value.constData());
+        for (const QVariant &item : *list) {
+            size += valueSize(item);
+        }
+        break;
+    }
+    case QMetaType::QVariantMap: {
+        const auto *map = static_cast<const QVariantMap *>(value.constData());
+        for (auto it = map->constBegin(); it != map->constEnd(); ++it) {
+            size += sizeof(QString) + stringSize(it.key()) +
+                    valueSize(it.value());
+        }
+        break;
+    }
+    case QMetaType::QVariantHash: {
+        const auto *hash =
+            static_cast<const QVariantHash *>(value.constData());
+        for (auto it = hash->constBegin(); it != hash->constEnd(); ++it) {
+            size += sizeof(QString) + stringSize(it.key()) +
+                    valueSize(it.value());
+        }
+        break;
+    }
+    default:
+        break;
+    }
+    return size;
+}
+
+}  // namespace
+
+ModelChangeJournal::ModelChangeJournal()
+    : m_memoryUsage(0),
+      m_memoryLimit(DefaultMemoryLimit),
+      m_mergeInterval(DefaultMergeInterval),
+      m_lastRecordTime(0),
+      m_mergeable(false),
+      m_restorable(false) {
+    m_clock.start();
+}
+
+void ModelChangeJournal::record(const Step &changes) {
+    if (changes.isEmpty()) {
+        return;
+    }
+
+    for (const Step &step : std::as_const(m_redo)) {
+        m_memoryUsage -= stepSize(step);
+    }
+    m_redo.clear();
+    m_restorable = false;
+
+    const qint64 now = m_clock.elapsed();
+
+    // Typing into a field produces one step rather than one per keystroke
+    if (m_mergeable && m_mergeInterval > 0 &&
+        now - m_lastRecordTime <= m_mergeInterval && changes.size() == 1 &&
+        m_undo.last().size() == 1 &&
+        m_undo.last().first().name == changes.first().name) {
+        ModelPropertyChange &merged = m_undo.last().first();
+        m_memoryUsage -= valueSize(merged.newValue);
+        merged.newValue = changes.first().newValue;
+        m_memoryUsage += valueSize(merged.newValue);
+
+        // Back to where the step started: nothing left to undo
+        if (merged.oldValue == merged.newValue) {
+            m_memoryUsage -= stepSize(m_undo.last());
+            m_undo.removeLast();
+            m_mergeable = false;
+        }
+    } else {
+        m_undo.append(changes);
+        m_memoryUsage += stepSize(changes);
+        m_mergeable = true;
+    }
+
+    m_lastRecordTime = now;
+    evict();
+}
+
+ModelChangeJournal::Step ModelChangeJournal::takeUndo() {
+    if (m_undo.isEmpty()) {
+        return Step();
+    }
+
+    Step step = m_undo.takeLast();
+    m_redo.append(step);
+    m_mergeable = false;
+    m_restorable = true;
+    return step;
+}
+
+ModelChangeJournal::Step ModelChangeJournal::takeRedo() {
+    if (m_redo.isEmpty()) {
+        return Step();
+    }
+
+    Step step = m_redo.takeLast();
+    m_undo.append(step);
+    m_mergeable = false;
+    m_restorable = true;
+    return step;
+}
+
+void ModelChangeJournal::restoreUndo() {
+    if (m_restorable && !m_redo.isEmpty()) {
+        m_undo.append(m_redo.takeLast());
+    }
+    m_restorable = false;
+}
+
+void ModelChangeJournal::restoreRedo() {
+    if (m_restorable && !m_undo.isEmpty()) {
+        m_redo.append(m_undo.takeLast());
+    }
+    m_restorable = false;
+}
+
+bool ModelChangeJournal::canUndo() const { return !m_undo.isEmpty(); }
+
+bool ModelChangeJournal::canRedo() const { return !m_redo.isEmpty(); }
+
+int ModelChangeJournal::undoCount() const { return int(m_undo.size()); }
+
+int ModelChangeJournal::redoCount() const { return int(m_redo.size()); }
+
+void ModelChangeJournal::clear() {
+    m_undo.clear();
+    m_redo.clear();
+    m_memoryUsage = 0;
+    m_mergeable = false;
+    m_restorable = false;
+}
+
+void ModelChangeJournal::setMemoryLimit(qint64 bytes) {
+    m_memoryLimit = bytes;
+    evict();
+}
+
+qint64 ModelChangeJournal::memoryLimit() const { return m_memoryLimit; }
+
+qint64 ModelChangeJournal::memoryUsage() const { return m_memoryUsage; }
+
+void ModelChangeJournal::setMergeInterval(qint64 msecs) {
+    m_mergeInterval = msecs;
+}
+
+qint64 ModelChangeJournal::mergeInterval() const { return m_mergeInterval; }
+
+qint64 ModelChangeJournal::stepSize(const Step &step) {
+    qint64 size = sizeof(Step);
+    for (const ModelPropertyChange &change : step) {
+        size += sizeof(ModelPropertyChange) +
+                change.name.size() * qint64(sizeof(QChar)) +
+                valueSize(change.oldValue) + valueSize(change.newValue);
+    }
+    return size;
+}
+
+void ModelChangeJournal::evict() {
+    // Redo history is the least likely to be used; drop it first
+    while (m_memoryUsage > m_memoryLimit && !m_redo.isEmpty()) {
+        m_memoryUsage -= stepSize(m_redo.takeFirst());
+        m_restorable = false;
+    }
+    while (m_memoryUsage > m_memoryLimit && !m_undo.isEmpty()) {
+        m_memoryUsage -= stepSize(m_undo.takeFirst());
+        m_mergeable = m_mergeable && !m_undo.isEmpty();
+        m_restorable = false;
+    }
+}
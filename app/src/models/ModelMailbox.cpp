@@ -0,0 +1,76 @@
+#include "models/ModelMailbox.h"
+#include <QList>
+#include <QSet>
+#include <algorithm>
+#include <utility>
+
+ModelMailbox::ModelMailbox() : m_head(nullptr) {}
+
+ModelMailbox::~ModelMailbox() {
+    Node *node = m_head.exchange(nullptr, std::memory_order_acquire);
+    while (node) {
+        Node *next = node->next;
+        delete node;
+        node = next;
+    }
+}
+
+bool ModelMailbox::post(int slot, const QString &propertyName,
+                        const QVariant &value) {
+    Node *node = new Node{slot, propertyName, value, nullptr};
+
+    Node *head = m_head.load(std::memory_order_relaxed);
+    do {
+        node->next = head;
+    } while (!m_head.compare_exchange_weak(head, node,
+                                           std::memory_order_release,
+                                           std::memory_order_relaxed));
+    return head == nullptr;
+}
+
+PropertyUpdate ModelMailbox::take() {
+    // Detaching the whole list at once means nodes are never popped
+    // individually, so there is no ABA problem
+    Node *node = m_head.exchange(nullptr, std::memory_order_acquire);
+
+    // The list runs newest first: the first value seen for a property is
+    // the one to keep
+    QList<Node *> latest;
+    QSet<int> seenSlots;
+    QSet<QString> seenNames;
+    while (node) {
+        Node *next = node->next;
+        const bool seen = node->slot >= 0
+                              ? seenSlots.contains(node->slot)
+                              : seenNames.contains(node->name);
+        if (seen) {
+            delete node;
+        } else {
+            if (node->slot >= 0) {
+                seenSlots.insert(node->slot);
+            } else {
+                seenNames.insert(node->name);
+            }
+            latest.append(node);
+        }
+        node = next;
+    }
+
+    std::reverse(latest.begin(), latest.end());
+
+    PropertyUpdate update;
+    update.reserve(latest.size());
+    for (Node *pending : std::as_const(latest)) {
+        if (pending->slot >= 0) {
+            update.set(pending->slot, pending->value);
+        } else {
+            update.set(pending->name, pending->value);
+        }
+        delete pending;
+    }
+    return update;
+}
+
+bool ModelMailbox::isEmpty() const {
+    return m_head.load(std::memory_order_acquire) == nullptr;
+}
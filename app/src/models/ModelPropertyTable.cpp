@@ -0,0 +1,23 @@
+#include "models/ModelPropertyTable.h"
+
+ModelPropertyTable::ModelPropertyTable(std::initializer_list<QString> names)
+    : m_names(names) {
+    m_slots.reserve(m_names.size());
+    for (int slot = 0; slot < m_names.size(); ++slot) {
+        Q_ASSERT_X(!m_slots.contains(m_names.at(slot)),
+                   "ModelPropertyTable", "duplicate property name");
+        m_slots.insert(m_names.at(slot), slot);
+    }
+}
+
+int ModelPropertyTable::slot(const QString &name) const {
+    return m_slots.value(name, -1);
+}
+
+QString ModelPropertyTable::name(int slot) const {
+    return m_names.value(slot);
+}
+
+const QStringList &ModelPropertyTable::names() const { return m_names; }
+
+int ModelPropertyTable::size() const { return int(m_names.size()); }
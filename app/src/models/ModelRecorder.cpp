@@ -0,0 +1,35 @@
+#include "models/ModelRecorder.h"
+
+ModelRecorder::ModelRecorder(QIODevice *device)
+    : m_stream(device), m_recordCount(0) {
+    m_stream.setVersion(StreamVersion);
+    m_stream << Magic << FormatVersion;
+    m_clock.start();
+}
+
+void ModelRecorder::record(const QList<ModelPropertyChange> &changes) {
+    if (changes.isEmpty()) {
+        return;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    m_stream << qint64(m_clock.elapsed()) << quint32(changes.size());
+    for (const ModelPropertyChange &change : changes) {
+        m_stream << qint32(change.slot);
+        if (change.slot < 0) {
+            m_stream << change.name;
+        }
+        m_stream << change.newValue;
+    }
+    ++m_recordCount;
+}
+
+int ModelRecorder::recordCount() const {
+    QMutexLocker locker(&m_mutex);
+    return m_recordCount;
+}
+
+bool ModelRecorder::isOk() const {
+    QMutexLocker locker(&m_mutex);
+    return m_stream.status() == QDataStream::Ok;
+}
@@ -0,0 +1,130 @@
+#include "models/ModelReplayer.h"
+#include <QTimer>
+#include <algorithm>
+#include "models/BaseModel.h"
+#include "models/ModelRecorder.h"
+
+ModelReplayer::ModelReplayer(QIODevice *device, BaseModel *model,
+                             QObject *parent)
+    : QObject(parent),
+      m_stream(device),
+      m_model(model),
+      m_timer(new QTimer(this)),
+      m_nextTime(0),
+      m_replayedCount(0),
+      m_running(false) {
+    m_stream.setVersion(ModelRecorder::StreamVersion);
+    m_timer->setSingleShot(true);
+    connect(m_timer, &QTimer::timeout, this, &ModelReplayer::applyDue);
+}
+
+bool ModelReplayer::start(Mode mode) {
+    quint32 magic = 0;
+    quint16 version = 0;
+    m_stream >> magic >> version;
+    if (m_stream.status() != QDataStream::Ok ||
+        magic != ModelRecorder::Magic ||
+        version > ModelRecorder::FormatVersion) {
+        return false;
+    }
+
+    m_replayedCount = 0;
+
+    if (mode == AsFastAsPossible) {
+        while (readNext()) {
+            if (m_model) {
+                m_model->applyUpdate(m_next);
+            }
+            ++m_replayedCount;
+        }
+        finish(m_stream.status() == QDataStream::Ok);
+        return true;
+    }
+
+    // Offsets are measured from the start of the replay rather than from
+    // the previous record, so timer latency does not accumulate
+    m_running = true;
+    m_clock.start();
+    if (!readNext()) {
+        finish(m_stream.status() == QDataStream::Ok);
+        return true;
+    }
+    m_timer->start(int(std::max<qint64>(0, m_nextTime - m_clock.elapsed())));
+    return true;
+}
+
+void ModelReplayer::stop() {
+    m_timer->stop();
+    m_running = false;
+}
+
+bool ModelReplayer::isRunning() const { return m_running; }
+
+int ModelReplayer::replayedCount() const { return m_replayedCount; }
+
+bool ModelReplayer::readNext() {
+    if (m_stream.atEnd()) {
+        return false;
+    }
+
+    qint64 time = 0;
+    quint32 count = 0;
+    m_stream >> time >> count;
+
+    // A recording of another model version may name slots this model does
+    // not have; treat it as corrupt rather than index out of the table
+    const int slotCount = m_model ? m_model->propertyTable().size() : 0;
+
+    m_next = PropertyUpdate();
+    for (quint32 i = 0; i < count && m_stream.status() == QDataStream::Ok;
+         ++i) {
+        qint32 slot = -1;
+        QString name;
+        QVariant value;
+        m_stream >> slot;
+        if (slot < 0) {
+            m_stream >> name;
+        }
+        m_stream >> value;
+        if (m_stream.status() != QDataStream::Ok) {
+            break;
+        }
+
+        if (slot >= 0) {
+            if (m_model && slot >= slotCount) {
+                m_stream.setStatus(QDataStream::ReadCorruptData);
+                break;
+            }
+            m_next.set(int(slot), value);
+        } else {
+            m_next.set(name, value);
+        }
+    }
+
+    m_nextTime = time;
+    return m_stream.status() == QDataStream::Ok;
+}
+
+void ModelReplayer::applyDue() {
+    // Apply everything that is due; a slow model catches up in one go
+    do {
+        if (m_model) {
+            m_model->applyUpdate(m_next);
+        }
+        ++m_replayedCount;
+
+        if (!readNext()) {
+            finish(m_stream.status() == QDataStream::Ok);
+            return;
+        }
+    } while (m_running && m_nextTime <= m_clock.elapsed());
+
+    if (m_running) {
+        m_timer->start(int(m_nextTime - m_clock.elapsed()));
+    }
+}
+
+void ModelReplayer::finish(bool ok) {
+    m_running = false;
+    emit finished(ok);
+}
@@ -0,0 +1,133 @@
+#include "models/ModelSerializer.h"
+#include <QBuffer>
+#include <QDataStream>
+#include <QDebug>
+#include <QFile>
+#include <QSaveFile>
+#include <algorithm>
+#include "models/BaseModel.h"
+
+namespace {
+
+constexpr quint32 kMagic = 0x514D444C;  // "QMDL"
+constexpr QDataStream::Version kStreamVersion = QDataStream::Qt_6_0;
+
+// Smallest possible record: empty name + zero value length
+constexpr qint64 kMinRecordSize = 8;
+
+}  // namespace
+
+bool ModelSerializer::write(const ModelSnapshot &snapshot, QIODevice *device) {
+    QDataStream out(device);
+    out.setVersion(kStreamVersion);
+
+    const QStringList names = snapshot.propertyNames();
+    out << kMagic << FormatVersion << quint32(names.size());
+
+    // Each value is encoded into a reused buffer first so that it can be
+    // length-prefixed; readers skip values they cannot decode
+    QByteArray record;
+    QBuffer recordDevice(&record);
+    recordDevice.open(QIODevice::WriteOnly);
+    QDataStream recordStream(&recordDevice);
+    recordStream.setVersion(kStreamVersion);
+
+    for (const QString &name : names) {
+        recordDevice.seek(0);
+        recordStream << snapshot.value(name);
+        const qint64 length = recordDevice.pos();
+
+        out << name << quint32(length);
+        out.writeRawData(record.constData(), int(length));
+    }
+
+    return recordStream.status() == QDataStream::Ok &&
+           out.status() == QDataStream::Ok;
+}
+
+bool ModelSerializer::read(const QByteArray &data, PropertyUpdate *update) {
+    QDataStream in(data);
+    in.setVersion(kStreamVersion);
+
+    quint32 magic = 0;
+    quint16 version = 0;
+    quint32 count = 0;
+    in >> magic >> version >> count;
+    if (in.status() != QDataStream::Ok || magic != kMagic ||
+        version > FormatVersion) {
+        return false;
+    }
+
+    // A corrupt count must not make us reserve gigabytes
+    update->reserve(std::min<qint64>(count, data.size() / kMinRecordSize));
+
+    QIODevice *device = in.device();
+    QString name;
+    quint32 length = 0;
+    for (quint32 index = 0; index < count; ++index) {
+        in >> name >> length;
+        if (in.status() != QDataStream::Ok) {
+            return false;
+        }
+
+        const qint64 end = device->pos() + length;
+        if (end > data.size()) {
+            return false;
+        }
+
+        QVariant value;
+        in >> value;
+        if (in.status() != QDataStream::Ok || device->pos() != end) {
+            // Written by a build that knows a type this one does not
+            in.resetStatus();
+            device->seek(end);
+            continue;
+        }
+        update->set(name, value);
+    }
+
+    return true;
+}
+
+bool ModelSerializer::save(const BaseModel &model, const QString &filePath) {
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Failed to open model file for writing:" << filePath;
+        return false;
+    }
+
+    if (!write(model.snapshot(), &file)) {
+        file.cancelWriting();
+        return false;
+    }
+    return file.commit();
+}
+
+bool ModelSerializer::load(const QString &filePath, BaseModel *model) {
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    PropertyUpdate update;
+    bool ok = false;
+    const qint64 size = file.size();
+    uchar *mapped = size > 0 ? file.map(0, size) : nullptr;
+    if (mapped) {
+        // Decoded values own their data, so the mapping can go right after
+        const QByteArray data = QByteArray::fromRawData(
+            reinterpret_cast<const char *>(mapped), size);
+        ok = read(data, &update);
+        file.unmap(mapped);
+    } else {
+        ok = read(file.readAll(), &update);
+    }
+
+    if (!ok) {
+        qWarning() << "Unsupported or corrupt model file:" << filePath;
+        return false;
+    }
+
+    model->applyUpdate(update);
+    return true;
+}
@@ -0,0 +1,49 @@
+#include "models/ModelSnapshot.h"
+
+namespace {
+
+const ModelPropertyTable &emptyPropertyTable() {
+    static const ModelPropertyTable table;
+    return table;
+}
+
+}  // namespace
+
+ModelSnapshot::ModelSnapshot()
+    : m_table(&emptyPropertyTable()), m_version(0) {}
+
+ModelSnapshot::ModelSnapshot(const ModelPropertyTable *table,
+                             const QList<QVariant> &values,
+                             const QHash<QString, QVariant> &properties,
+                             quint64 version)
+    : m_table(table),
+      m_values(values),
+      m_properties(properties),
+      m_version(version) {}
+
+quint64 ModelSnapshot::version() const { return m_version; }
+
+QVariant ModelSnapshot::value(const QString &propertyName) const {
+    const int slot = m_table->slot(propertyName);
+    if (slot >= 0) {
+        return m_values.value(slot);
+    }
+    return m_properties.value(propertyName);
+}
+
+QVariant ModelSnapshot::value(int slot) const { return m_values.value(slot); }
+
+QStringList ModelSnapshot::propertyNames() const {
+    QStringList names;
+    names.reserve(m_values.size() + m_properties.size());
+    for (int slot = 0; slot < m_values.size(); ++slot) {
+        if (m_values.at(slot).isValid()) {
+            names.append(m_table->name(slot));
+        }
+    }
+    for (auto it = m_properties.constBegin(); it != m_properties.constEnd();
+         ++it) {
+        names.append(it.key());
+    }
+    return names;
+}
@@ -0,0 +1,102 @@
+#include "models/StatusHistory.h"
+#include <algorithm>
+#include <utility>
+
+StatusHistory::StatusHistory(int capacity)
+    : m_ring(std::max(capacity, 1)), m_head(0), m_size(0) {}
+
+void StatusHistory::record(const QString &message, qint64 timestamp) {
+    const int string = intern(message);
+
+    const int capacity = int(m_ring.size());
+    const int index = (m_head + m_size) % capacity;
+    if (m_size == capacity) {
+        // Full: the new entry replaces the oldest one
+        release(m_ring.at(index).string);
+        m_head = (m_head + 1) % capacity;
+    } else {
+        ++m_size;
+    }
+    m_ring[index] = {timestamp, string};
+}
+
+QList<StatusHistory::Entry> StatusHistory::entries() const {
+    QList<Entry> entries;
+    entries.reserve(m_size);
+    for (int i = 0; i < m_size; ++i) {
+        const Slot &slot = m_ring.at((m_head + i) % m_ring.size());
+        entries.append({slot.timestamp, m_strings.at(slot.string)});
+    }
+    return entries;
+}
+
+int StatusHistory::size() const { return m_size; }
+
+int StatusHistory::capacity() const { return int(m_ring.size()); }
+
+void StatusHistory::setCapacity(int capacity) {
+    capacity = std::max(capacity, 1);
+    if (capacity == m_ring.size()) {
+        return;
+    }
+
+    // Re-intern the newest entries that fit into a fresh pool, so that
+    // after shrinking the pool is no larger than the smaller history
+    const QList<QString> strings = std::exchange(m_strings, {});
+    m_refCounts = {};
+    m_freeStrings = {};
+    m_stringIndex = {};
+
+    const int kept = std::min(m_size, capacity);
+    const int first = m_head + m_size - kept;
+    QList<Slot> ring(capacity);
+    for (int i = 0; i < kept; ++i) {
+        const Slot &slot = m_ring.at((first + i) % m_ring.size());
+        ring[i] = {slot.timestamp, intern(strings.at(slot.string))};
+    }
+    m_ring = ring;
+    m_head = 0;
+    m_size = kept;
+}
+
+int StatusHistory::poolSize() const { return int(m_stringIndex.size()); }
+
+void StatusHistory::clear() {
+    m_head = 0;
+    m_size = 0;
+    m_strings.clear();
+    m_refCounts.clear();
+    m_freeStrings.clear();
+    m_stringIndex.clear();
+}
+
+int StatusHistory::intern(const QString &message) {
+    auto it = m_stringIndex.constFind(message);
+    if (it != m_stringIndex.constEnd()) {
+        ++m_refCounts[it.value()];
+        return it.value();
+    }
+
+    int string = 0;
+    if (!m_freeStrings.isEmpty()) {
+        string = m_freeStrings.takeLast();
+        m_strings[string] = message;
+        m_refCounts[string] = 1;
+    } else {
+        string = int(m_strings.size());
+        m_strings.append(message);
+        m_refCounts.append(1);
+    }
+    m_stringIndex.insert(message, string);
+    return string;
+}
+
+void StatusHistory::release(int string) {
+    if (--m_refCounts[string] > 0) {
+        return;
+    }
+
+    m_stringIndex.remove(m_strings.at(string));
+    m_strings[string] = QString();
+    m_freeStrings.append(string);
+}
@@ -0,0 +1,352 @@
+#include "services/ConfigurationJournal.h"
+#include <QDataStream>
+#include <QDebug>
+#include <QDir>
+#include <QSaveFile>
+#include <QtEndian>
+#include <algorithm>
+
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr quint32 kSnapshotMagic = 0x51535443;  // "QSTC"
+constexpr quint16 kSnapshotFormatVersion = 1;
+constexpr QDataStream::Version kStreamVersion = QDataStream::Qt_6_0;
+
+// Record header: quint32 payload length + quint16 payload checksum
+constexpr qint64 kRecordHeaderSize = 6;
+
+const QString kSnapshotFileName = QStringLiteral("snapshot.dat");
+const QString kSegmentPrefix = QStringLiteral("journal-");
+const QString kSegmentSuffix = QStringLiteral(".log");
+
+bool syncToDisk(QFile &file) {
+    if (!file.flush()) {
+        return false;
+    }
+#ifdef Q_OS_WIN
+    return _commit(file.handle()) == 0;
+#else
+    return ::fsync(file.handle()) == 0;
+#endif
+}
+
+}  // namespace
+
+ConfigurationJournal::ConfigurationJournal(const QString &directory)
+    : m_directory(directory),
+      m_generation(0),
+      m_compactionThreshold(DefaultCompactionThreshold),
+      m_empty(true) {}
+
+ConfigurationJournal::~ConfigurationJournal() {
+    if (m_segment.isOpen()) {
+        m_segment.flush();
+        m_segment.close();
+    }
+}
+
+bool ConfigurationJournal::open(QHash<QString, QVariant> *values) {
+    if (!QDir().mkpath(m_directory)) {
+        return false;
+    }
+
+    values->clear();
+    m_empty = true;
+
+    // Snapshot first; generation 1 is the first segment ever written
+    quint64 baseGeneration = 1;
+    if (readSnapshot(m_directory, &baseGeneration, values)) {
+        m_empty = false;
+    }
+
+    // Leftovers of a compaction that committed its snapshot but was
+    // interrupted before cleaning up
+    removeSegmentsBefore(m_directory, baseGeneration);
+
+    quint64 lastGeneration = baseGeneration;
+    const QList<quint64> generations = segmentGenerations(m_directory);
+    for (quint64 generation : generations) {
+        // New records are appended to the newest segment only
+        const bool active = generation == generations.last();
+        bool hadRecords = false;
+        if (!replaySegment(segmentPath(m_directory, generation), active,
+                           values, &hadRecords)) {
+            return false;
+        }
+        m_empty = m_empty && !hadRecords;
+        lastGeneration = std::max(lastGeneration, generation);
+    }
+
+    return openSegment(lastGeneration);
+}
+
+bool ConfigurationJournal::isEmpty() const { return m_empty; }
+
+bool ConfigurationJournal::appendSet(const QString &key,
+                                     const QVariant &value) {
+    return append(SetOperation, key, value);
+}
+
+bool ConfigurationJournal::appendRemove(const QString &key) {
+    return append(RemoveOperation, key, QVariant());
+}
+
+bool ConfigurationJournal::appendClear() {
+    return append(ClearOperation, QString(), QVariant());
+}
+
+bool ConfigurationJournal::sync() {
+    return m_segment.isOpen() && syncToDisk(m_segment);
+}
+
+qint64 ConfigurationJournal::size() const { return m_segment.size(); }
+
+void ConfigurationJournal::setCompactionThreshold(qint64 bytes) {
+    m_compactionThreshold = bytes;
+}
+
+bool ConfigurationJournal::needsCompaction() const {
+    return m_segment.isOpen() && m_segment.size() > m_compactionThreshold;
+}
+
+quint64 ConfigurationJournal::rotate() {
+    // The old segment must be complete on disk before a snapshot that
+    // depends on it can replace it
+    if (m_segment.isOpen()) {
+        syncToDisk(m_segment);
+        m_segment.close();
+    }
+
+    return openSegment(m_generation + 1) ? m_generation : 0;
+}
+
+QString ConfigurationJournal::directory() const { return m_directory; }
+
+bool ConfigurationJournal::writeSnapshot(
+    const QString &directory, quint64 generation,
+    const QHash<QString, QVariant> &values) {
+    QByteArray payload;
+    {
+        QDataStream out(&payload, QIODevice::WriteOnly);
+        out.setVersion(kStreamVersion);
+        out << values;
+        if (out.status() != QDataStream::Ok) {
+            return false;
+        }
+    }
+
+    // QSaveFile syncs the data to disk on commit and renames it atomically
+    QSaveFile file(QDir(directory).filePath(kSnapshotFileName));
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+
+    QDataStream out(&file);
+    out.setVersion(kStreamVersion);
+    out << kSnapshotMagic << kSnapshotFormatVersion << generation
+        << quint64(payload.size()) << qChecksum(payload);
+    out.writeRawData(payload.constData(), payload.size());
+
+    if (out.status() != QDataStream::Ok) {
+        file.cancelWriting();
+        return false;
+    }
+    return file.commit();
+}
+
+void ConfigurationJournal::removeSegmentsBefore(const QString &directory,
+                                                quint64 generation) {
+    const QList<quint64> generations = segmentGenerations(directory);
+    for (quint64 segment : generations) {
+        if (segment < generation) {
+            QFile::remove(segmentPath(directory, segment));
+        }
+    }
+}
+
+bool ConfigurationJournal::append(Operation operation, const QString &key,
+                                  const QVariant &value) {
+    if (!m_segment.isOpen()) {
+        return false;
+    }
+
+    QByteArray payload;
+    {
+        QDataStream out(&payload, QIODevice::WriteOnly);
+        out.setVersion(kStreamVersion);
+        out << quint8(operation) << key;
+        if (operation == SetOperation) {
+            out << value;
+        }
+    }
+
+    QByteArray record(kRecordHeaderSize, Qt::Uninitialized);
+    qToBigEndian<quint32>(quint32(payload.size()), record.data());
+    qToBigEndian<quint16>(qChecksum(payload), record.data() + 4);
+    record.append(payload);
+
+    // One write per record keeps a torn record at the very end of the file
+    if (m_segment.write(record) != record.size()) {
+        return false;
+    }
+    return m_segment.flush();
+}
+
+bool ConfigurationJournal::openSegment(quint64 generation) {
+    m_segment.setFileName(segmentPath(m_directory, generation));
+    if (!m_segment.open(QIODevice::ReadWrite | QIODevice::Append)) {
+        return false;
+    }
+
+    m_generation = generation;
+    return true;
+}
+
+QString ConfigurationJournal::segmentPath(const QString &directory,
+                                          quint64 generation) {
+    return QDir(directory).filePath(kSegmentPrefix +
+                                    QString::number(generation) +
+                                    kSegmentSuffix);
+}
+
+QList<quint64> ConfigurationJournal::segmentGenerations(
+    const QString &directory) {
+    QList<quint64> generations;
+    const QStringList names = QDir(directory).entryList(
+        QStringList(kSegmentPrefix + "*" + kSegmentSuffix), QDir::Files);
+    for (const QString &name : names) {
+        bool ok = false;
+        const quint64 generation =
+            name.mid(kSegmentPrefix.size(),
+                     name.size() - kSegmentPrefix.size() -
+                         kSegmentSuffix.size())
+                .toULongLong(&ok);
+        if (ok && generation > 0) {
+            generations.append(generation);
+        }
+    }
+
+    std::sort(generations.begin(), generations.end());
+    return generations;
+}
+
+bool ConfigurationJournal::readSnapshot(const QString &directory,
+                                        quint64 *generation,
+                                        QHash<QString, QVariant> *values) {
+    QFile file(QDir(directory).filePath(kSnapshotFileName));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream in(&file);
+    in.setVersion(kStreamVersion);
+
+    quint32 magic = 0;
+    quint16 formatVersion = 0;
+    quint64 snapshotGeneration = 0;
+    quint64 payloadSize = 0;
+    quint16 checksum = 0;
+    in >> magic >> formatVersion >> snapshotGeneration >> payloadSize >>
+        checksum;
+    if (in.status() != QDataStream::Ok || magic != kSnapshotMagic ||
+        formatVersion != kSnapshotFormatVersion || snapshotGeneration == 0) {
+        return false;
+    }
+
+    const QByteArray payload = file.read(qint64(payloadSize));
+    if (quint64(payload.size()) != payloadSize ||
+        qChecksum(payload) != checksum) {
+        return false;
+    }
+
+    QDataStream payloadStream(payload);
+    payloadStream.setVersion(kStreamVersion);
+    QHash<QString, QVariant> stored;
+    payloadStream >> stored;
+    if (payloadStream.status() != QDataStream::Ok) {
+        return false;
+    }
+
+    *values = stored;
+    *generation = snapshotGeneration;
+    return true;
+}
+
+bool ConfigurationJournal::replaySegment(const QString &path, bool active,
+                                         QHash<QString, QVariant> *values,
+                                         bool *hadRecords) {
+    QFile file(path);
+    if (!file.open(active ? QIODevice::ReadWrite : QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    const QByteArray data = file.readAll();
+    qint64 offset = 0;
+    while (data.size() - offset >= kRecordHeaderSize) {
+        const char *header = data.constData() + offset;
+        const qint64 length = qFromBigEndian<quint32>(header);
+        const quint16 checksum = qFromBigEndian<quint16>(header + 4);
+        if (length > data.size() - offset - kRecordHeaderSize) {
+            break;
+        }
+
+        const QByteArray payload = QByteArray::fromRawData(
+            header + kRecordHeaderSize, qsizetype(length));
+        if (qChecksum(payload) != checksum) {
+            break;
+        }
+
+        QDataStream in(payload);
+        in.setVersion(kStreamVersion);
+        quint8 operation = 0;
+        QString key;
+        in >> operation >> key;
+
+        bool valid = in.status() == QDataStream::Ok;
+        if (valid && operation == SetOperation) {
+            QVariant value;
+            in >> value;
+            valid = in.status() == QDataStream::Ok;
+            if (valid) {
+                values->insert(key, value);
+            }
+        } else if (valid && operation == RemoveOperation) {
+            values->remove(key);
+        } else if (valid && operation == ClearOperation) {
+            values->clear();
+        } else {
+            valid = false;
+        }
+
+        if (!valid) {
+            break;
+        }
+
+        *hadRecords = true;
+        offset += kRecordHeaderSize + length;
+    }
+
+    if (offset == data.size()) {
+        return true;
+    }
+
+    // A sealed segment was complete on disk before the next one was
+    // started, so damage there is not a torn write; keep the file for
+    // inspection and carry on with the later segments
+    if (!active) {
+        qWarning() << "Skipping damaged records in configuration journal"
+                   << path << "from offset" << offset;
+        return true;
+    }
+
+    // Drop a torn tail left by a crash so new records follow valid ones
+    qWarning() << "Truncating damaged configuration journal" << path
+               << "at offset" << offset;
+    return file.resize(offset);
+}
@@ -0,0 +1,114 @@
+#include "services/ConfigurationKeyIndex.h"
+
+ConfigurationKeyIndex::ConfigurationKeyIndex() : d(new Data) {}
+
+void ConfigurationKeyIndex::insert(const QString &key) {
+    // Avoid detaching shared storage when nothing changes
+    if (!contains(key)) {
+        d->keys.insert(key);
+    }
+}
+
+void ConfigurationKeyIndex::remove(const QString &key) {
+    if (contains(key)) {
+        d->keys.erase(key);
+    }
+}
+
+void ConfigurationKeyIndex::clear() {
+    if (size() > 0) {
+        d->keys.clear();
+    }
+}
+
+bool ConfigurationKeyIndex::contains(const QString &key) const {
+    return d->keys.find(key) != d->keys.end();
+}
+
+qsizetype ConfigurationKeyIndex::size() const {
+    return static_cast<qsizetype>(d->keys.size());
+}
+
+QStringList ConfigurationKeyIndex::keys() const {
+    QStringList result;
+    result.reserve(size());
+    for (const QString &key : d->keys) {
+        result.append(key);
+    }
+    return result;
+}
+
+ConfigurationKeyIndex::Range ConfigurationKeyIndex::range(
+    const QString &group) const {
+    const QString prefix = groupPrefix(group);
+    if (prefix.isEmpty()) {
+        return Range(d->keys.begin(), d->keys.end());
+    }
+
+    return Range(d->keys.lower_bound(prefix),
+                 d->keys.lower_bound(groupUpperBound(prefix)));
+}
+
+QStringList ConfigurationKeyIndex::keysUnder(const QString &group) const {
+    QStringList result;
+    for (const QString &key : range(group)) {
+        result.append(key);
+    }
+    return result;
+}
+
+QStringList ConfigurationKeyIndex::childGroups(const QString &group) const {
+    const QString prefix = groupPrefix(group);
+    const Range keys = range(group);
+
+    QStringList result;
+    auto it = keys.begin();
+    while (it != keys.end()) {
+        const qsizetype separator = it->indexOf(u'/', prefix.size());
+        if (separator < 0) {
+            ++it;
+            continue;
+        }
+
+        // Skip the whole subtree of this group in one lookup
+        const QString childPrefix = it->left(separator + 1);
+        result.append(childPrefix.mid(prefix.size(),
+                                      separator - prefix.size()));
+        it = d->keys.lower_bound(groupUpperBound(childPrefix));
+    }
+    return result;
+}
+
+QStringList ConfigurationKeyIndex::childKeys(const QString &group) const {
+    const QString prefix = groupPrefix(group);
+    const Range keys = range(group);
+
+    QStringList result;
+    auto it = keys.begin();
+    while (it != keys.end()) {
+        const qsizetype separator = it->indexOf(u'/', prefix.size());
+        if (separator < 0) {
+            result.append(it->mid(prefix.size()));
+            ++it;
+            continue;
+        }
+
+        it = d->keys.lower_bound(groupUpperBound(it->left(separator + 1)));
+    }
+    return result;
+}
+
+QString ConfigurationKeyIndex::groupPrefix(const QString &group) {
+    if (group.isEmpty() || group.endsWith(u'/')) {
+        return group;
+    }
+    return group + u'/';
+}
+
+QString ConfigurationKeyIndex::groupUpperBound(const QString &prefix) {
+    // Every key starting with "group/" sorts before "group0", because '0'
+    // is the character directly after '/'.
+    QString bound = prefix;
+    bound[bound.size() - 1] = QChar(u'/' + 1);
+    return bound;
+}
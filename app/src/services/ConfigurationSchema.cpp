@@ -0,0 +1,118 @@
+#include "services/ConfigurationSchema.h"
+#include <algorithm>
+#include <array>
+
+namespace {
+
+using Entry = ConfigurationSchema::Entry;
+
+constexpr double kNoMinimum = 1;
+constexpr double kNoMaximum = 0;
+
+constexpr Entry boolKey(std::u16string_view key, bool defaultValue) {
+    return {key, QMetaType::Bool, defaultValue ? 1.0 : 0.0, {},
+            kNoMinimum, kNoMaximum};
+}
+
+constexpr Entry intKey(std::u16string_view key, int defaultValue,
+                       int minimum, int maximum) {
+    return {key, QMetaType::Int, double(defaultValue), {}, double(minimum),
+            double(maximum)};
+}
+
+constexpr Entry stringKey(std::u16string_view key,
+                          std::u16string_view defaultValue) {
+    return {key, QMetaType::QString, 0, defaultValue, kNoMinimum,
+            kNoMaximum};
+}
+
+// Sorted by key for binary search
+constexpr std::array kEntries = {
+    stringKey(u"application/language", u"en"),
+    stringKey(u"application/theme", u"default"),
+    intKey(u"window/height", 700, 200, 16384),
+    boolKey(u"window/maximized", false),
+    intKey(u"window/width", 1000, 200, 16384),
+};
+
+constexpr bool keyLess(const Entry &lhs, const Entry &rhs) {
+    return lhs.key < rhs.key;
+}
+
+static_assert(std::is_sorted(kEntries.begin(), kEntries.end(), keyLess),
+              "configuration schema must be sorted by key");
+static_assert(std::all_of(kEntries.begin(), kEntries.end(),
+                          [](const Entry &entry) {
+                              return !entry.hasRange() ||
+                                     (entry.defaultNumber >= entry.minimum &&
+                                      entry.defaultNumber <= entry.maximum);
+                          }),
+              "configuration defaults must lie within their range");
+
+QString toQString(std::u16string_view text) {
+    return QStringView(text.data(), qsizetype(text.size())).toString();
+}
+
+}  // namespace
+
+const ConfigurationSchema::Entry *ConfigurationSchema::find(
+    QStringView key) {
+    const std::u16string_view needle(key.utf16(), size_t(key.size()));
+    const auto it = std::lower_bound(
+        kEntries.begin(), kEntries.end(), needle,
+        [](const Entry &entry, std::u16string_view value) {
+            return entry.key < value;
+        });
+    if (it == kEntries.end() || it->key != needle) {
+        return nullptr;
+    }
+    return &*it;
+}
+
+QVariant ConfigurationSchema::defaultValue(const Entry &entry) {
+    switch (entry.type) {
+    case QMetaType::Bool:
+        return QVariant(entry.defaultNumber != 0);
+    case QMetaType::Int:
+        return QVariant(int(entry.defaultNumber));
+    case QMetaType::Double:
+        return QVariant(entry.defaultNumber);
+    case QMetaType::QString:
+        return QVariant(toQString(entry.defaultString));
+    default:
+        return QVariant();
+    }
+}
+
+QHash<QString, QVariant> ConfigurationSchema::defaults() {
+    QHash<QString, QVariant> values;
+    values.reserve(qsizetype(kEntries.size()));
+    for (const Entry &entry : kEntries) {
+        values.insert(toQString(entry.key), defaultValue(entry));
+    }
+    return values;
+}
+
+bool ConfigurationSchema::normalize(const QString &key, const QVariant &value,
+                                    QVariant *result) {
+    const Entry *entry = find(key);
+    if (!entry) {
+        *result = value;
+        return true;
+    }
+
+    QVariant converted = value;
+    if (!converted.convert(QMetaType(entry->type))) {
+        return false;
+    }
+
+    if (entry->hasRange()) {
+        const double number = converted.toDouble();
+        if (number < entry->minimum || number > entry->maximum) {
+            return false;
+        }
+    }
+
+    *result = converted;
+    return true;
+}
@@ -1,10 +1,149 @@
 #include "services/ConfigurationService.h"
 #include <QDebug>
 #include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QProcessEnvironment>
+#include <QSaveFile>
+#include <QSignalBlocker>
 #include <QStandardPaths>
+#include <QTemporaryFile>
+#include <QThread>
+#include <QTimer>
+#include "services/ConfigurationSchema.h"
+
+namespace {
+
+// Delay between the first unsaved change and the background save
+constexpr int kAutoSaveDelayMs = 500;
+
+QHash<QString, QVariant> readAllValues(const QSettings &settings) {
+    QHash<QString, QVariant> values;
+    const QStringList keys = settings.allKeys();
+    for (const QString &key : keys) {
+        values.insert(key, settings.value(key));
+    }
+    return values;
+}
+
+QHash<QString, QVariant> validateLayer(const QHash<QString, QVariant> &values) {
+    QHash<QString, QVariant> result;
+    result.reserve(values.size());
+    for (auto it = values.constBegin(); it != values.constEnd(); ++it) {
+        QVariant value;
+        if (ConfigurationSchema::normalize(it.key(), it.value(), &value)) {
+            result.insert(it.key(), value);
+        } else {
+            qWarning() << "Ignoring invalid configuration value" << it.key()
+                       << it.value();
+        }
+    }
+    return result;
+}
+
+bool writeSettingsFile(const QString &filePath,
+                       const QHash<QString, QVariant> &values) {
+    const QFileInfo info(filePath);
+    if (!QDir().mkpath(info.absolutePath())) {
+        return false;
+    }
+
+    // Serialize with QSettings' own INI writer into a scratch file, so the
+    // result stays readable by QSettings
+    QTemporaryFile scratch(info.absolutePath() + "/.XXXXXX.tmp");
+    if (!scratch.open()) {
+        return false;
+    }
+    scratch.close();
+
+    {
+        QSettings writer(scratch.fileName(), QSettings::IniFormat);
+        writer.clear();
+        for (auto it = values.constBegin(); it != values.constEnd(); ++it) {
+            writer.setValue(it.key(), it.value());
+        }
+        writer.sync();
+        if (writer.status() != QSettings::NoError) {
+            return false;
+        }
+    }
+
+    QFile serialized(scratch.fileName());
+    if (!serialized.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    const QByteArray data = serialized.readAll();
+    serialized.close();
+
+    // QSaveFile writes to a temporary file, syncs it to disk on commit and
+    // atomically renames it over the target
+    QSaveFile target(filePath);
+    if (!target.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    if (target.write(data) != data.size()) {
+        target.cancelWriting();
+        return false;
+    }
+    return target.commit();
+}
+
+bool writeNativeSettings(const QHash<QString, QVariant> &values) {
+    // A separate instance is safe to use on this thread
+    QSettings settings;
+    settings.clear();
+    for (auto it = values.constBegin(); it != values.constEnd(); ++it) {
+        settings.setValue(it.key(), it.value());
+    }
+    settings.sync();
+    return settings.status() == QSettings::NoError;
+}
+
+}  // namespace
 
 ConfigurationService::ConfigurationService(QObject *parent)
-    : IService(parent), m_settings(nullptr), m_running(false) {}
+    : IService(parent),
+      m_settings(nullptr),
+      m_userLayerDirty(false),
+      m_userLayerRevision(0),
+      m_running(false),
+      m_snapshot(std::make_shared<const ConfigurationSnapshot>()),
+      m_snapshotVersion(0),
+      m_publishPending(false),
+      m_nextSubscriptionId(1),
+      m_journalCompactionThreshold(
+          ConfigurationJournal::DefaultCompactionThreshold),
+      m_compactionRunning(false),
+      m_compactionPending(false),
+      m_compactionRequests(0),
+      m_shareSystemLayer(false),
+      m_autoSaveTimer(new QTimer(this)),
+      m_saveGeneration(0),
+      m_supersededSaves(0) {
+    // One writer at a time keeps saves in request order
+    m_savePool.setMaxThreadCount(1);
+
+    m_autoSaveTimer->setSingleShot(true);
+    m_autoSaveTimer->setInterval(kAutoSaveDelayMs);
+    connect(m_autoSaveTimer, &QTimer::timeout, this,
+            &ConfigurationService::saveConfigurationAsync);
+}
+
+ConfigurationService::~ConfigurationService() {
+    // Listeners may already be gone; write without telling anyone
+    const QSignalBlocker blocker(this);
+
+    // Changes inside the debounce window would otherwise be lost
+    m_autoSaveTimer->stop();
+    if (m_userLayerDirty) {
+        saveConfiguration();
+    } else if (m_journal) {
+        waitForPendingSaves();
+        m_journal->sync();
+    } else {
+        waitForPendingSaves();
+    }
+}
 
 bool ConfigurationService::initialize() {
     setupSettings();
@@ -32,7 +171,15 @@ void ConfigurationService::stop() {
         return;
     }
 
-    saveConfiguration();
+    // Shutdown barrier: nothing may be left unwritten
+    m_autoSaveTimer->stop();
+    if (m_journal) {
+        saveConfiguration();
+    } else {
+        saveConfigurationAsync();
+        waitForPendingSaves();
+    }
+
     m_running = false;
     emit serviceStopped();
 }
@@ -44,33 +191,39 @@ QString ConfigurationService::getServiceName() const {
 }
 
 QVariant ConfigurationService::getConfiguration(const QString &key) const {
-    // First check cache
-    if (m_cache.contains(key)) {
-        return m_cache.value(key);
-    }
-
-    // Then check settings
-    if (m_settings) {
-        return m_settings->value(key);
+    // Other threads only ever see published snapshots
+    if (!isOwnerThread()) {
+        return snapshot()->value(key);
     }
 
-    return QVariant();
+    // The cache holds the flattened layers, so a miss is authoritative
+    return m_cache.value(key);
 }
 
 bool ConfigurationService::setConfiguration(const QString &key,
                                             const QVariant &value) {
-    QVariant oldValue = getConfiguration(key);
+    Q_ASSERT_X(isOwnerThread(), "ConfigurationService::setConfiguration",
+               "configuration must be modified from the owner thread");
 
-    // Update cache
-    m_cache[key] = value;
+    QVariant normalized;
+    if (!ConfigurationSchema::normalize(key, value, &normalized)) {
+        qWarning() << "Rejected invalid configuration value" << key << value;
+        return false;
+    }
 
-    // Update settings
-    if (m_settings) {
-        m_settings->setValue(key, value);
+    // Update user layer and persist the change
+    m_layers[UserLayer].insert(key, normalized);
+    if (m_journal) {
+        journalWritten(m_journal->appendSet(key, normalized));
+    } else {
+        markUserLayerDirty();
     }
 
-    // Emit signals
-    emit configurationChanged(key, value);
+    // A higher layer may still override the new value
+    if (resolveKey(key)) {
+        schedulePublish();
+        notifyChanges(QStringList(key));
+    }
 
     return true;
 }
@@ -82,76 +235,265 @@ QVariant ConfigurationService::getConfiguration(
 }
 
 bool ConfigurationService::hasConfiguration(const QString &key) const {
-    return m_cache.contains(key) || (m_settings && m_settings->contains(key));
+    if (!isOwnerThread()) {
+        return snapshot()->contains(key);
+    }
+
+    return m_cache.contains(key);
 }
 
 bool ConfigurationService::removeConfiguration(const QString &key) {
-    // Remove from cache
-    m_cache.remove(key);
+    Q_ASSERT_X(isOwnerThread(), "ConfigurationService::removeConfiguration",
+               "configuration must be modified from the owner thread");
 
-    // Remove from settings
-    if (m_settings) {
-        m_settings->remove(key);
+    // Remove from user layer and persist the change
+    if (!m_layers[UserLayer].remove(key)) {
+        return false;
+    }
+    if (m_journal) {
+        journalWritten(m_journal->appendRemove(key));
+    } else {
+        markUserLayerDirty();
+    }
+
+    // A lower layer (e.g. the defaults) may provide the value now
+    if (resolveKey(key)) {
+        schedulePublish();
+        notifyChanges(QStringList(key));
     }
 
-    emit configurationChanged(key, QVariant());
     return true;
 }
 
 QStringList ConfigurationService::getAllKeys() const {
-    QStringList keys;
+    if (!isOwnerThread()) {
+        return snapshot()->keys();
+    }
 
-    // Add keys from cache
-    keys.append(m_cache.keys());
+    return m_keyIndex.keys();
+}
 
-    // Add keys from settings
-    if (m_settings) {
-        keys.append(m_settings->allKeys());
+QStringList ConfigurationService::keysUnder(const QString &group) const {
+    return keyIndex().keysUnder(group);
+}
+
+QStringList ConfigurationService::childGroups(const QString &group) const {
+    return keyIndex().childGroups(group);
+}
+
+QStringList ConfigurationService::childKeys(const QString &group) const {
+    return keyIndex().childKeys(group);
+}
+
+ConfigurationKeyIndex ConfigurationService::keyIndex() const {
+    if (!isOwnerThread()) {
+        return snapshot()->keyIndex();
     }
 
-    // Remove duplicates
-    keys.removeDuplicates();
-    return keys;
+    return m_keyIndex;
 }
 
 void ConfigurationService::clearConfiguration() {
-    m_cache.clear();
-
-    if (m_settings) {
-        m_settings->clear();
+    const QStringList changed =
+        replaceLayer(UserLayer, QHash<QString, QVariant>());
+    if (m_journal) {
+        journalWritten(m_journal->appendClear());
+    } else {
+        markUserLayerDirty();
     }
 
     emit configurationChanged(QString(), QVariant());
+    for (const QString &key : changed) {
+        notifySubscribers(key, m_cache.value(key));
+    }
 }
 
 bool ConfigurationService::saveConfiguration() {
+    // Journal records are already written; only make them durable
+    if (m_journal) {
+        waitForPendingSaves();
+        const bool success = m_journal->sync();
+        if (success) {
+            emit configurationSaved();
+        }
+        return success;
+    }
+
     if (!m_settings) {
         return false;
     }
 
-    // Sync cache to settings
-    for (auto it = m_cache.constBegin(); it != m_cache.constEnd(); ++it) {
+    // Let queued background saves finish first so they cannot overwrite
+    // this one
+    waitForPendingSaves();
+
+    // Background saves replace the file behind QSettings' back; re-read it
+    // first, or clear() would miss keys they wrote and the merge in sync()
+    // would bring those keys back
+    m_settings->sync();
+
+    // Sync user layer to settings
+    m_settings->clear();
+    const QHash<QString, QVariant> &values = m_layers[UserLayer];
+    for (auto it = values.constBegin(); it != values.constEnd(); ++it) {
         m_settings->setValue(it.key(), it.value());
     }
 
     m_settings->sync();
+    m_autoSaveTimer->stop();
+
+    // A failed save leaves the layer dirty for the next attempt
+    if (m_settings->status() != QSettings::NoError) {
+        return false;
+    }
 
+    m_userLayerDirty = false;
     emit configurationSaved();
     return true;
 }
 
-bool ConfigurationService::loadConfiguration() {
+void ConfigurationService::saveConfigurationAsync() {
+    // With a journal, a full save means folding it into a new snapshot
+    if (m_journal) {
+        compactJournal(true);
+        return;
+    }
+
     if (!m_settings) {
+        emit configurationSaveFinished(false);
+        return;
+    }
+
+    // Snapshot the user layer; the copy is O(1) thanks to implicit sharing.
+    // The layer stays dirty until the write has succeeded.
+    const QHash<QString, QVariant> values = m_layers[UserLayer];
+    const quint64 revision = m_userLayerRevision;
+    m_autoSaveTimer->stop();
+
+    // Native stores that are not files (registry, plists) are written
+    // through QSettings on the worker; everything else is an INI file
+#if defined(Q_OS_WIN) || defined(Q_OS_DARWIN)
+    const bool fileBased = m_settings->format() == QSettings::IniFormat;
+#else
+    const bool fileBased = true;
+#endif
+    const QString filePath = m_settings->fileName();
+    const quint64 generation = ++m_saveGeneration;
+
+    m_savePool.start([this, values, fileBased, filePath, generation,
+                      revision]() {
+        // A newer save is queued behind this one and will write a newer
+        // snapshot; skip this one and let the newer one report for both
+        if (generation != m_saveGeneration.loadAcquire()) {
+            m_supersededSaves.ref();
+            return;
+        }
+
+        const bool success = fileBased ? writeSettingsFile(filePath, values)
+                                       : writeNativeSettings(values);
+        const int completed = m_supersededSaves.fetchAndStoreAcquire(0) + 1;
+
+        QMetaObject::invokeMethod(
+            this,
+            [this, success, completed, revision]() {
+                // Later changes still need a save of their own
+                if (success && revision == m_userLayerRevision) {
+                    m_userLayerDirty = false;
+                }
+                for (int i = 0; i < completed; ++i) {
+                    emit configurationSaveFinished(success);
+                }
+                if (success) {
+                    emit configurationSaved();
+                } else {
+                    emit serviceError(tr("Failed to save configuration"));
+                }
+            },
+            Qt::QueuedConnection);
+    });
+}
+
+bool ConfigurationService::waitForPendingSaves(int msecs) {
+    return m_savePool.waitForDone(msecs);
+}
+
+bool ConfigurationService::setJournalDirectory(const QString &directory) {
+    Q_ASSERT_X(isOwnerThread(), "ConfigurationService::setJournalDirectory",
+               "configuration must be modified from the owner thread");
+
+    if (getJournalDirectory() == directory) {
+        return true;
+    }
+
+    // Unsaved changes belong to the store being left; write them before
+    // an existing journal replaces the user layer
+    flushPendingChanges();
+    if (m_journal) {
+        m_journal->sync();
+        m_journal.reset();
+    }
+    m_compactionRunning = false;
+    m_compactionPending = false;
+    m_compactionRequests = 0;
+
+    // Back to the settings store, which has to catch up with the journal
+    if (directory.isEmpty()) {
+        markUserLayerDirty();
+        return true;
+    }
+
+    auto journal = std::make_unique<ConfigurationJournal>(directory);
+    journal->setCompactionThreshold(m_journalCompactionThreshold);
+
+    QHash<QString, QVariant> values;
+    if (!journal->open(&values)) {
+        emit serviceError(tr("Failed to open configuration journal"));
         return false;
     }
 
-    // Load all settings into cache
-    m_cache.clear();
-    QStringList keys = m_settings->allKeys();
-    for (const QString &key : keys) {
-        m_cache[key] = m_settings->value(key);
+    // Replayed records come from disk like any settings file; restore the
+    // schema types and drop values that do not fit
+    values = validateLayer(values);
+
+    // Seed a new journal with the current user configuration
+    if (journal->isEmpty()) {
+        values = m_layers[UserLayer];
+        const quint64 generation = journal->rotate();
+        if (generation == 0 || !ConfigurationJournal::writeSnapshot(
+                                   directory, generation, values)) {
+            emit serviceError(tr("Failed to open configuration journal"));
+            return false;
+        }
+        ConfigurationJournal::removeSegmentsBefore(directory, generation);
     }
 
+    m_journal = std::move(journal);
+    m_userLayerDirty = false;
+    m_autoSaveTimer->stop();
+
+    notifyChanges(replaceLayer(UserLayer, values));
+    return true;
+}
+
+QString ConfigurationService::getJournalDirectory() const {
+    return m_journal ? m_journal->directory() : QString();
+}
+
+void ConfigurationService::setJournalCompactionThreshold(qint64 bytes) {
+    m_journalCompactionThreshold = bytes;
+    if (m_journal) {
+        m_journal->setCompactionThreshold(bytes);
+    }
+}
+
+bool ConfigurationService::loadConfiguration() {
+    if (!m_settings) {
+        return false;
+    }
+
+    flushPendingChanges();
+    reloadUserLayer();
+
     emit configurationLoaded();
     return true;
 }
@@ -175,32 +517,307 @@ QString ConfigurationService::getConfigurationFile() const {
     return m_configurationFile;
 }
 
-void ConfigurationService::initializeDefaults() {
-    // Set default configuration values
-    if (!hasConfiguration("application/theme")) {
-        setConfiguration("application/theme", "default");
+bool ConfigurationService::setLayer(Layer layer,
+                                    const QHash<QString, QVariant> &values) {
+    Q_ASSERT_X(isOwnerThread(), "ConfigurationService::setLayer",
+               "configuration must be modified from the owner thread");
+
+    if (layer == UserLayer || layer < 0 || layer >= LayerCount) {
+        return false;
     }
 
-    if (!hasConfiguration("application/language")) {
-        setConfiguration("application/language", "en");
+    notifyChanges(replaceLayer(layer, validateLayer(values)));
+    return true;
+}
+
+QHash<QString, QVariant> ConfigurationService::layer(Layer layer) const {
+    Q_ASSERT_X(isOwnerThread(), "ConfigurationService::layer",
+               "layers can only be inspected from the owner thread");
+
+    if (layer < 0 || layer >= LayerCount) {
+        return QHash<QString, QVariant>();
     }
+    return m_layers[layer];
+}
+
+ConfigurationService::Layer ConfigurationService::effectiveLayer(
+    const QString &key) const {
+    Q_ASSERT_X(isOwnerThread(), "ConfigurationService::effectiveLayer",
+               "layers can only be inspected from the owner thread");
 
-    if (!hasConfiguration("window/width")) {
-        setConfiguration("window/width", 1000);
+    for (int layer = LayerCount - 1; layer >= 0; --layer) {
+        if (m_layers[layer].contains(key)) {
+            return static_cast<Layer>(layer);
+        }
     }
+    return LayerCount;
+}
 
-    if (!hasConfiguration("window/height")) {
-        setConfiguration("window/height", 700);
+bool ConfigurationService::loadSystemConfiguration(const QString &filePath) {
+    if (!QFile::exists(filePath)) {
+        return false;
     }
 
-    if (!hasConfiguration("window/maximized")) {
-        setConfiguration("window/maximized", false);
+    // Another instance may already have parsed the same file
+    if (m_shareSystemLayer) {
+        if (!m_sharedSystemLayer ||
+            m_sharedSystemLayer->sourceFile() != filePath) {
+            m_sharedSystemLayer =
+                std::make_unique<ConfigurationSharedLayer>(filePath);
+        }
+
+        QHash<QString, QVariant> values;
+        if (m_sharedSystemLayer->read(&values)) {
+            setLayer(SystemLayer, values);
+            return true;
+        }
     }
+
+    // Stamp first: an edit made while parsing must not be published as
+    // matching the edited file
+    ConfigurationSharedLayer::SourceStamp stamp;
+    if (m_sharedSystemLayer) {
+        stamp = m_sharedSystemLayer->sourceStamp();
+    }
+
+    const QSettings systemSettings(filePath, QSettings::IniFormat);
+    const QHash<QString, QVariant> values = readAllValues(systemSettings);
+
+    const bool success = systemSettings.status() == QSettings::NoError;
+    if (success && m_sharedSystemLayer &&
+        !m_sharedSystemLayer->publish(values, stamp)) {
+        qWarning() << "Failed to share system configuration" << filePath;
+    }
+
+    setLayer(SystemLayer, values);
+    return success;
+}
+
+void ConfigurationService::setSystemLayerSharingEnabled(bool enabled) {
+    m_shareSystemLayer = enabled;
+    if (!enabled) {
+        m_sharedSystemLayer.reset();
+    }
+}
+
+bool ConfigurationService::isSystemLayerSharingEnabled() const {
+    return m_shareSystemLayer;
+}
+
+quint64 ConfigurationService::sharedSystemLayerVersion() const {
+    return m_sharedSystemLayer ? m_sharedSystemLayer->version() : 0;
+}
+
+bool ConfigurationService::loadProfile(const QString &name,
+                                       const QString &filePath) {
+    if (!QFile::exists(filePath)) {
+        return false;
+    }
+
+    const QSettings profileSettings(filePath, QSettings::IniFormat);
+    addProfile(name, readAllValues(profileSettings));
+    return profileSettings.status() == QSettings::NoError;
+}
+
+void ConfigurationService::addProfile(const QString &name,
+                                      const QHash<QString, QVariant> &values) {
+    Q_ASSERT_X(isOwnerThread(), "ConfigurationService::addProfile",
+               "configuration must be modified from the owner thread");
+
+    // Validate once here so that switching never has to
+    m_profiles.insert(name, validateLayer(values));
+    if (name == m_activeProfile) {
+        const QStringList changed =
+            replaceLayer(ProfileLayer, m_profiles.value(name));
+        notifyChanges(changed);
+        emit activeProfileChanged(name, changed);
+    }
+}
+
+bool ConfigurationService::removeProfile(const QString &name) {
+    Q_ASSERT_X(isOwnerThread(), "ConfigurationService::removeProfile",
+               "configuration must be modified from the owner thread");
+
+    if (!m_profiles.contains(name)) {
+        return false;
+    }
+
+    if (name == m_activeProfile) {
+        setActiveProfile(QString());
+    }
+    m_profiles.remove(name);
+    return true;
+}
+
+QStringList ConfigurationService::profiles() const {
+    QStringList names = m_profiles.keys();
+    names.sort();
+    return names;
+}
+
+bool ConfigurationService::setActiveProfile(const QString &name) {
+    Q_ASSERT_X(isOwnerThread(), "ConfigurationService::setActiveProfile",
+               "configuration must be modified from the owner thread");
+
+    if (!name.isEmpty() && !m_profiles.contains(name)) {
+        return false;
+    }
+    if (name == m_activeProfile) {
+        return true;
+    }
+
+    // Assigning the resident hash shares its storage with the layer
+    m_activeProfile = name;
+    const QStringList changed =
+        replaceLayer(ProfileLayer, m_profiles.value(name));
+    notifyChanges(changed);
+    emit activeProfileChanged(name, changed);
+    return true;
+}
+
+QString ConfigurationService::activeProfile() const {
+    return m_activeProfile;
+}
+
+void ConfigurationService::loadEnvironment(const QString &prefix) {
+    const QProcessEnvironment environment =
+        QProcessEnvironment::systemEnvironment();
+
+    QHash<QString, QVariant> values;
+    const QStringList names = environment.keys();
+    for (const QString &name : names) {
+        if (name.size() <= prefix.size() || !name.startsWith(prefix)) {
+            continue;
+        }
+
+        QString key = name.mid(prefix.size());
+        key.replace(QStringLiteral("__"), QStringLiteral("/"));
+        values.insert(key, environment.value(name));
+    }
+
+    setLayer(EnvironmentLayer, values);
+}
+
+void ConfigurationService::loadCommandLine(const QStringList &arguments) {
+    static const QString option = QStringLiteral("--config");
+    static const QString optionWithValue = QStringLiteral("--config=");
+
+    QHash<QString, QVariant> values;
+    for (qsizetype i = 0; i < arguments.size(); ++i) {
+        QString assignment;
+        if (arguments.at(i) == option && i + 1 < arguments.size()) {
+            assignment = arguments.at(++i);
+        } else if (arguments.at(i).startsWith(optionWithValue)) {
+            assignment = arguments.at(i).mid(optionWithValue.size());
+        } else {
+            continue;
+        }
+
+        const qsizetype separator = assignment.indexOf(u'=');
+        if (separator > 0) {
+            values.insert(assignment.left(separator),
+                          assignment.mid(separator + 1));
+        }
+    }
+
+    setLayer(CommandLineLayer, values);
+}
+
+ConfigurationSnapshotPtr ConfigurationService::snapshot() const {
+    // Only the owner thread may touch the pending flag and the cache
+    if (isOwnerThread() && m_publishPending) {
+        publishSnapshot();
+    }
+
+    QReadLocker locker(&m_snapshotLock);
+    return m_snapshot;
+}
+
+void ConfigurationService::publishSnapshot() const {
+    Q_ASSERT_X(isOwnerThread(), "ConfigurationService::publishSnapshot",
+               "snapshots must be published from the owner thread");
+
+    if (!m_publishPending) {
+        return;
+    }
+    m_publishPending = false;
+
+    // QHash and the key index are implicitly shared: the snapshot shares
+    // storage with the live data until the next write detaches it. That
+    // detach copies the live data once per publish cycle, O(n); the index
+    // is only copied when a key is added or removed. The snapshot is built
+    // outside the lock; only the swap is guarded.
+    ConfigurationSnapshotPtr snapshot =
+        std::make_shared<const ConfigurationSnapshot>(++m_snapshotVersion,
+                                                      m_cache, m_keyIndex);
+    QWriteLocker locker(&m_snapshotLock);
+    m_snapshot.swap(snapshot);
+}
+
+int ConfigurationService::subscribe(const QString &pattern, QObject *context,
+                                    ChangeCallback callback,
+                                    Qt::ConnectionType type) {
+    Q_ASSERT_X(isOwnerThread(), "ConfigurationService::subscribe",
+               "subscriptions must be managed from the owner thread");
+
+    const int id = m_nextSubscriptionId++;
+
+    Subscription subscription;
+    subscription.id = id;
+    subscription.context = context ? context : this;
+    subscription.callback = std::move(callback);
+    subscription.type = type;
+    if (context) {
+        subscription.destroyedConnection =
+            connect(context, &QObject::destroyed, this,
+                    [this, id]() { unsubscribe(id); });
+    }
+
+    m_subscriptions[pattern].append(subscription);
+    m_subscriptionPatterns.insert(id, pattern);
+    return id;
+}
+
+void ConfigurationService::unsubscribe(int subscriptionId) {
+    Q_ASSERT_X(isOwnerThread(), "ConfigurationService::unsubscribe",
+               "subscriptions must be managed from the owner thread");
+
+    auto patternIt = m_subscriptionPatterns.find(subscriptionId);
+    if (patternIt == m_subscriptionPatterns.end()) {
+        return;
+    }
+
+    auto listIt = m_subscriptions.find(patternIt.value());
+    m_subscriptionPatterns.erase(patternIt);
+    if (listIt == m_subscriptions.end()) {
+        return;
+    }
+
+    QList<Subscription> &list = listIt.value();
+    for (qsizetype i = 0; i < list.size(); ++i) {
+        if (list.at(i).id == subscriptionId) {
+            disconnect(list.at(i).destroyedConnection);
+            list.removeAt(i);
+            break;
+        }
+    }
+
+    if (list.isEmpty()) {
+        m_subscriptions.erase(listIt);
+    }
+}
+
+void ConfigurationService::initializeDefaults() {
+    // Defaults come from the schema table and live in their own layer, so
+    // they are never written to the user's settings store
+    notifyChanges(
+        replaceLayer(DefaultsLayer, ConfigurationSchema::defaults()));
 }
 
 void ConfigurationService::setupSettings() {
-    // Clean up old settings
+    // Clean up old settings, persisting unsaved changes to the old store
     if (m_settings) {
+        flushPendingChanges();
         delete m_settings;
         m_settings = nullptr;
     }
@@ -214,4 +831,255 @@ void ConfigurationService::setupSettings() {
         m_settings =
             new QSettings(m_configurationFile, QSettings::IniFormat, this);
     }
+
+    reloadUserLayer();
+}
+
+void ConfigurationService::reloadUserLayer() {
+    // Pick up files replaced by background saves or other processes
+    waitForPendingSaves();
+
+    // A journal is the authoritative store while enabled
+    if (m_journal) {
+        return;
+    }
+
+    m_settings->sync();
+    m_userLayerDirty = false;
+
+    // INI files store every value as a string; restore the schema types
+    notifyChanges(replaceLayer(
+        UserLayer, validateLayer(readAllValues(*m_settings))));
+}
+
+void ConfigurationService::markUserLayerDirty() {
+    m_userLayerDirty = true;
+    ++m_userLayerRevision;
+
+    // Bound the latency of the first change rather than postponing the
+    // save for as long as changes keep coming
+    if (!m_autoSaveTimer->isActive()) {
+        m_autoSaveTimer->start();
+    }
+}
+
+void ConfigurationService::flushPendingChanges() {
+    if (m_userLayerDirty) {
+        saveConfiguration();
+    } else {
+        waitForPendingSaves();
+    }
+}
+
+void ConfigurationService::journalWritten(bool success) {
+    if (!success) {
+        emit serviceError(tr("Failed to write configuration journal"));
+        return;
+    }
+
+    if (m_journal->needsCompaction()) {
+        compactJournal(false);
+    }
+}
+
+void ConfigurationService::compactJournal(bool requested) {
+    if (!m_journal) {
+        return;
+    }
+
+    // The running compaction works on an older copy of the user layer, so
+    // run again once it is done
+    m_compactionPending = true;
+    if (requested) {
+        ++m_compactionRequests;
+    }
+    if (!m_compactionRunning) {
+        startCompaction();
+    }
+}
+
+void ConfigurationService::startCompaction() {
+    // This run answers every request that waited for it
+    const int requests = m_compactionRequests;
+    m_compactionPending = false;
+    m_compactionRequests = 0;
+
+    // New records go to a fresh segment while the worker folds the older
+    // ones, represented by this copy of the user layer, into a snapshot
+    const quint64 generation = m_journal->rotate();
+    if (generation == 0) {
+        emit serviceError(tr("Failed to compact configuration journal"));
+        for (int i = 0; i < requests; ++i) {
+            emit configurationSaveFinished(false);
+        }
+        return;
+    }
+
+    m_compactionRunning = true;
+    const QString directory = m_journal->directory();
+    const QHash<QString, QVariant> values = m_layers[UserLayer];
+
+    m_savePool.start([this, directory, generation, values, requests]() {
+        const bool success =
+            ConfigurationJournal::writeSnapshot(directory, generation, values);
+        if (success) {
+            ConfigurationJournal::removeSegmentsBefore(directory, generation);
+        }
+
+        QMetaObject::invokeMethod(
+            this,
+            [this, success, requests]() {
+                m_compactionRunning = false;
+                for (int i = 0; i < requests; ++i) {
+                    emit configurationSaveFinished(success);
+                }
+                if (success) {
+                    emit configurationSaved();
+                } else {
+                    emit serviceError(
+                        tr("Failed to compact configuration journal"));
+                }
+
+                if (m_compactionPending && m_journal) {
+                    startCompaction();
+                }
+            },
+            Qt::QueuedConnection);
+    });
+}
+
+QStringList ConfigurationService::replaceLayer(
+    Layer layer, const QHash<QString, QVariant> &values) {
+    const QHash<QString, QVariant> oldValues = m_layers[layer];
+    m_layers[layer] = values;
+
+    // Only keys this layer provided before or provides now can change
+    QStringList changed;
+    for (auto it = oldValues.constBegin(); it != oldValues.constEnd(); ++it) {
+        auto newIt = values.constFind(it.key());
+        const bool layerChanged =
+            newIt == values.constEnd() || newIt.value() != it.value();
+        if (layerChanged && resolveKey(it.key())) {
+            changed.append(it.key());
+        }
+    }
+    for (auto it = values.constBegin(); it != values.constEnd(); ++it) {
+        if (!oldValues.contains(it.key()) && resolveKey(it.key())) {
+            changed.append(it.key());
+        }
+    }
+
+    if (!changed.isEmpty()) {
+        schedulePublish();
+    }
+    return changed;
+}
+
+bool ConfigurationService::resolveKey(const QString &key) {
+    // The highest layer that provides the key wins
+    for (int layer = LayerCount - 1; layer >= 0; --layer) {
+        auto it = m_layers[layer].constFind(key);
+        if (it == m_layers[layer].constEnd()) {
+            continue;
+        }
+
+        auto current = m_cache.find(key);
+        if (current == m_cache.end()) {
+            m_cache.insert(key, it.value());
+            m_keyIndex.insert(key);
+            return true;
+        }
+        if (current.value() == it.value()) {
+            return false;
+        }
+        current.value() = it.value();
+        return true;
+    }
+
+    if (m_cache.remove(key)) {
+        m_keyIndex.remove(key);
+        return true;
+    }
+    return false;
+}
+
+void ConfigurationService::notifyChanges(const QStringList &keys) {
+    for (const QString &key : keys) {
+        const QVariant value = m_cache.value(key);
+        emit configurationChanged(key, value);
+        notifySubscribers(key, value);
+    }
+}
+
+void ConfigurationService::schedulePublish() {
+    // Coalesce all writes made during one event loop iteration into a
+    // single snapshot, so bursts of writes pay for one copy, not one each.
+    if (m_publishPending) {
+        return;
+    }
+
+    m_publishPending = true;
+    QMetaObject::invokeMethod(
+        this, [this]() { publishSnapshot(); }, Qt::QueuedConnection);
+}
+
+bool ConfigurationService::isOwnerThread() const {
+    return QThread::currentThread() == thread();
+}
+
+void ConfigurationService::notifySubscribers(const QString &key,
+                                             const QVariant &value) {
+    if (m_subscriptions.isEmpty()) {
+        return;
+    }
+
+    // Probe the key itself and each of its enclosing groups, from the
+    // root ("") down to the key's direct parent. The cost depends on the
+    // depth of the key, not on the number of subscribers.
+    QStringList patterns;
+    patterns.append(QString());
+    qsizetype separator = key.indexOf(u'/');
+    while (separator >= 0) {
+        patterns.append(key.left(separator + 1));
+        separator = key.indexOf(u'/', separator + 1);
+    }
+    patterns.append(key);
+
+    for (const QString &pattern : std::as_const(patterns)) {
+        auto it = m_subscriptions.constFind(pattern);
+        if (it == m_subscriptions.constEnd()) {
+            continue;
+        }
+
+        // Copy, so callbacks may (un)subscribe while we iterate
+        const QList<Subscription> subscribers = it.value();
+        for (const Subscription &subscription : subscribers) {
+            deliver(subscription, key, value);
+        }
+    }
+}
+
+void ConfigurationService::deliver(const Subscription &subscription,
+                                   const QString &key, const QVariant &value) {
+    // The context is gone; the destroyed() handler has not run yet
+    QObject *context = subscription.context.data();
+    if (!context) {
+        return;
+    }
+
+    const bool direct =
+        subscription.type == Qt::DirectConnection ||
+        (subscription.type == Qt::AutoConnection &&
+         context->thread() == QThread::currentThread());
+    if (direct) {
+        subscription.callback(key, value);
+        return;
+    }
+
+    QMetaObject::invokeMethod(
+        context,
+        [callback = subscription.callback, key, value]() {
+            callback(key, value);
+        },
+        Qt::QueuedConnection);
 }
@@ -0,0 +1,238 @@
+#include "services/ConfigurationSharedLayer.h"
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <QFileInfo>
+#include <cstring>
+
+namespace {
+
+constexpr quint32 kSharedLayerMagic = 0x51535348;  // "QSSH"
+constexpr quint32 kSharedLayerFormatVersion = 2;
+constexpr QDataStream::Version kStreamVersion = QDataStream::Qt_6_0;
+
+// Room for the source file to grow without recreating the segment
+constexpr qsizetype kMinimumCapacity = 64 * 1024;
+
+// Fixed layout at the start of the segment, followed by the payload
+struct SharedLayerHeader {
+    quint32 magic;
+    quint32 formatVersion;
+    quint64 version;
+    qint64 sourceModified;
+    qint64 sourceSize;
+    quint64 payloadSize;
+    quint16 checksum;
+    quint32 successor;  // Index of the segment that replaced this one, or 0
+};
+
+QString segmentKey(const QString &filePath, quint32 segment) {
+    const QByteArray path =
+        QFileInfo(filePath).absoluteFilePath().toUtf8();
+    return QStringLiteral("qt-simple-template-config-") +
+           QString::fromLatin1(
+               QCryptographicHash::hash(path, QCryptographicHash::Sha1)
+                   .toHex()) +
+           QLatin1Char('-') + QString::number(segment);
+}
+
+bool createOrAttach(QSharedMemory *memory, qsizetype capacity) {
+    return memory->create(capacity) ||
+           (memory->error() == QSharedMemory::AlreadyExists &&
+            memory->attach());
+}
+
+}  // namespace
+
+ConfigurationSharedLayer::ConfigurationSharedLayer(const QString &sourceFile)
+    : m_sourceFile(sourceFile), m_memory(segmentKey(sourceFile, 0)),
+      m_segment(0), m_version(0) {}
+
+ConfigurationSharedLayer::~ConfigurationSharedLayer() {
+    if (m_memory.isAttached()) {
+        m_memory.detach();
+    }
+}
+
+bool ConfigurationSharedLayer::read(QHash<QString, QVariant> *values) {
+    if (!attach()) {
+        return false;
+    }
+
+    const SourceStamp stamp = sourceStamp();
+    QByteArray payload;
+    SharedLayerHeader header;
+
+    // Copy out under the lock; decoding happens without holding it
+    m_memory.lock();
+    std::memcpy(&header, m_memory.constData(), sizeof(header));
+    const bool current =
+        header.magic == kSharedLayerMagic &&
+        header.formatVersion == kSharedLayerFormatVersion &&
+        header.sourceModified == stamp.modified &&
+        header.sourceSize == stamp.size &&
+        header.payloadSize <= quint64(m_memory.size()) - sizeof(header);
+    if (current) {
+        payload = QByteArray(
+            static_cast<const char *>(m_memory.constData()) + sizeof(header),
+            qsizetype(header.payloadSize));
+    }
+    m_memory.unlock();
+
+    if (!current || qChecksum(payload) != header.checksum) {
+        return false;
+    }
+
+    QDataStream in(payload);
+    in.setVersion(kStreamVersion);
+    QHash<QString, QVariant> stored;
+    in >> stored;
+    if (in.status() != QDataStream::Ok) {
+        return false;
+    }
+
+    *values = stored;
+    m_version = header.version;
+    return true;
+}
+
+ConfigurationSharedLayer::SourceStamp
+ConfigurationSharedLayer::sourceStamp() const {
+    const QFileInfo info(m_sourceFile);
+    SourceStamp stamp;
+    if (info.exists()) {
+        stamp.modified = info.lastModified().toMSecsSinceEpoch();
+        stamp.size = info.size();
+    }
+    return stamp;
+}
+
+bool ConfigurationSharedLayer::publish(const QHash<QString, QVariant> &values,
+                                       const SourceStamp &stamp) {
+    QByteArray payload;
+    {
+        QDataStream out(&payload, QIODevice::WriteOnly);
+        out.setVersion(kStreamVersion);
+        out << values;
+        if (out.status() != QDataStream::Ok) {
+            return false;
+        }
+    }
+
+    const qsizetype required =
+        qsizetype(sizeof(SharedLayerHeader)) + payload.size();
+    if (!attach()) {
+        // First publisher: leave room for the file to grow
+        const qsizetype capacity = qMax(required * 2, kMinimumCapacity);
+        if (!createOrAttach(&m_memory, capacity)) {
+            qWarning() << "Failed to create shared configuration segment"
+                       << m_memory.errorString();
+            return false;
+        }
+    }
+
+    // A successor starts empty; the version counter carries over
+    quint64 previousVersion = 0;
+    if (m_memory.size() < required && !grow(required, &previousVersion)) {
+        return false;
+    }
+
+    m_memory.lock();
+    char *data = static_cast<char *>(m_memory.data());
+    SharedLayerHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    if (header.magic == kSharedLayerMagic) {
+        previousVersion = qMax(previousVersion, header.version);
+    }
+
+    header.magic = kSharedLayerMagic;
+    header.formatVersion = kSharedLayerFormatVersion;
+    header.version = previousVersion + 1;
+    header.sourceModified = stamp.modified;
+    header.sourceSize = stamp.size;
+    header.payloadSize = quint64(payload.size());
+    header.checksum = qChecksum(payload);
+
+    std::memcpy(data + sizeof(header), payload.constData(), payload.size());
+    std::memcpy(data, &header, sizeof(header));
+    m_memory.unlock();
+
+    m_version = header.version;
+    return true;
+}
+
+quint64 ConfigurationSharedLayer::version() const { return m_version; }
+
+QString ConfigurationSharedLayer::sourceFile() const { return m_sourceFile; }
+
+bool ConfigurationSharedLayer::attach() {
+    if (!m_memory.isAttached() &&
+        !(m_memory.attach() &&
+          m_memory.size() >= qsizetype(sizeof(SharedLayerHeader)))) {
+        return false;
+    }
+
+    // Follow the links to the newest segment
+    for (;;) {
+        SharedLayerHeader header;
+        m_memory.lock();
+        std::memcpy(&header, m_memory.constData(), sizeof(header));
+        m_memory.unlock();
+
+        if (header.magic != kSharedLayerMagic ||
+            header.formatVersion != kSharedLayerFormatVersion ||
+            header.successor <= m_segment) {
+            return true;
+        }
+
+        m_segment = header.successor;
+        m_memory.setKey(segmentKey(m_sourceFile, m_segment));
+        if (!m_memory.attach() ||
+            m_memory.size() < qsizetype(sizeof(SharedLayerHeader))) {
+            return false;
+        }
+    }
+}
+
+bool ConfigurationSharedLayer::grow(qsizetype required,
+                                    quint64 *previousVersion) {
+    while (m_memory.size() < required) {
+        const quint32 next = m_segment + 1;
+        const qsizetype capacity = qMax(required * 2, kMinimumCapacity);
+
+        QSharedMemory larger(segmentKey(m_sourceFile, next));
+        if (!createOrAttach(&larger, capacity)) {
+            qWarning() << "Failed to grow shared configuration segment"
+                       << m_sourceFile << larger.errorString();
+            return false;
+        }
+
+        // Point readers of the old segment at the new one
+        m_memory.lock();
+        char *data = static_cast<char *>(m_memory.data());
+        SharedLayerHeader header;
+        std::memcpy(&header, data, sizeof(header));
+        if (header.magic != kSharedLayerMagic ||
+            header.formatVersion != kSharedLayerFormatVersion) {
+            std::memset(&header, 0, sizeof(header));
+            header.magic = kSharedLayerMagic;
+            header.formatVersion = kSharedLayerFormatVersion;
+        }
+        *previousVersion = qMax(*previousVersion, header.version);
+        header.successor = next;
+        std::memcpy(data, &header, sizeof(header));
+        m_memory.unlock();
+
+        // Attach before the local handle detaches, so that the segment is
+        // never left without users
+        m_segment = next;
+        m_memory.setKey(larger.key());
+        if (!m_memory.attach()) {
+            qWarning() << "Failed to attach shared configuration segment"
+                       << m_sourceFile << m_memory.errorString();
+            return false;
+        }
+    }
+    return true;
+}
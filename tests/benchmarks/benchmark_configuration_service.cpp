@@ -0,0 +1,250 @@
+#include <QCoreApplication>
+#include <QSettings>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QtTest>
+#include <memory>
+#include "services/ConfigurationService.h"
+
+class BenchmarkConfigurationService : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    // Benchmark test cases
+    void benchmarkInitializeAndStart_data();
+    void benchmarkInitializeAndStart();
+    void benchmarkGetConfigurationHit_data();
+    void benchmarkGetConfigurationHit();
+    void benchmarkGetConfigurationMiss_data();
+    void benchmarkGetConfigurationMiss();
+    void benchmarkHasConfigurationMiss_data();
+    void benchmarkHasConfigurationMiss();
+    void benchmarkGetAllKeys_data();
+    void benchmarkGetAllKeys();
+    void benchmarkSetConfigurationBurst_data();
+    void benchmarkSetConfigurationBurst();
+    void benchmarkSaveConfiguration_data();
+    void benchmarkSaveConfiguration();
+
+private:
+    static constexpr int kLookupsPerIteration = 1000;
+
+    static void addScaleRows();
+    static QString keyName(int index);
+    QString iniFilePath() const;
+    void populateStore(bool iniFormat, int keyCount);
+    std::unique_ptr<ConfigurationService> createService(bool iniFormat);
+
+    QTemporaryDir m_tempDir;
+};
+
+void BenchmarkConfigurationService::initTestCase() {
+    qDebug("Starting ConfigurationService benchmarks");
+
+    // Keep the native store away from the real user configuration
+    QStandardPaths::setTestModeEnabled(true);
+    QCoreApplication::setOrganizationName("QtSimpleTemplateBenchmarks");
+    QCoreApplication::setApplicationName("benchmark_configuration_service");
+    QVERIFY(m_tempDir.isValid());
+}
+
+void BenchmarkConfigurationService::cleanupTestCase() {
+    QSettings native;
+    native.clear();
+    native.sync();
+
+    qDebug("Finished ConfigurationService benchmarks");
+}
+
+void BenchmarkConfigurationService::addScaleRows() {
+    QTest::addColumn<bool>("iniFormat");
+    QTest::addColumn<int>("keyCount");
+
+    for (int keyCount : {100, 10000, 100000}) {
+        QTest::addRow("native/%d", keyCount) << false << keyCount;
+        QTest::addRow("ini/%d", keyCount) << true << keyCount;
+    }
+}
+
+QString BenchmarkConfigurationService::keyName(int index) {
+    // 100 keys per group, like a store with per-document sections
+    return QString("group%1/key%2").arg(index / 100).arg(index % 100);
+}
+
+QString BenchmarkConfigurationService::iniFilePath() const {
+    return m_tempDir.filePath("config.ini");
+}
+
+void BenchmarkConfigurationService::populateStore(bool iniFormat,
+                                                  int keyCount) {
+    std::unique_ptr<QSettings> settings =
+        iniFormat ? std::make_unique<QSettings>(iniFilePath(),
+                                                QSettings::IniFormat)
+                  : std::make_unique<QSettings>();
+    settings->clear();
+    for (int i = 0; i < keyCount; ++i) {
+        settings->setValue(keyName(i), i);
+    }
+    settings->sync();
+}
+
+std::unique_ptr<ConfigurationService>
+BenchmarkConfigurationService::createService(bool iniFormat) {
+    auto service = std::make_unique<ConfigurationService>();
+    if (iniFormat) {
+        service->setConfigurationFile(iniFilePath());
+    }
+    service->initialize();
+    service->start();
+    return service;
+}
+
+void BenchmarkConfigurationService::benchmarkInitializeAndStart_data() {
+    addScaleRows();
+}
+
+void BenchmarkConfigurationService::benchmarkInitializeAndStart() {
+    QFETCH(bool, iniFormat);
+    QFETCH(int, keyCount);
+    populateStore(iniFormat, keyCount);
+
+    QBENCHMARK {
+        std::unique_ptr<ConfigurationService> service =
+            createService(iniFormat);
+        Q_UNUSED(service);
+    }
+}
+
+void BenchmarkConfigurationService::benchmarkGetConfigurationHit_data() {
+    addScaleRows();
+}
+
+void BenchmarkConfigurationService::benchmarkGetConfigurationHit() {
+    QFETCH(bool, iniFormat);
+    QFETCH(int, keyCount);
+    populateStore(iniFormat, keyCount);
+    std::unique_ptr<ConfigurationService> service = createService(iniFormat);
+
+    QStringList keys;
+    for (int i = 0; i < kLookupsPerIteration; ++i) {
+        keys.append(keyName(i * 7919 % keyCount));
+    }
+
+    QBENCHMARK {
+        for (const QString &key : std::as_const(keys)) {
+            QVariant value = service->getConfiguration(key);
+            Q_UNUSED(value);
+        }
+    }
+}
+
+void BenchmarkConfigurationService::benchmarkGetConfigurationMiss_data() {
+    addScaleRows();
+}
+
+void BenchmarkConfigurationService::benchmarkGetConfigurationMiss() {
+    QFETCH(bool, iniFormat);
+    QFETCH(int, keyCount);
+    populateStore(iniFormat, keyCount);
+    std::unique_ptr<ConfigurationService> service = createService(iniFormat);
+
+    QStringList keys;
+    for (int i = 0; i < kLookupsPerIteration; ++i) {
+        keys.append(QString("missing/key%1").arg(i));
+    }
+
+    QBENCHMARK {
+        for (const QString &key : std::as_const(keys)) {
+            QVariant value = service->getConfiguration(key, 0);
+            Q_UNUSED(value);
+        }
+    }
+}
+
+void BenchmarkConfigurationService::benchmarkHasConfigurationMiss_data() {
+    addScaleRows();
+}
+
+void BenchmarkConfigurationService::benchmarkHasConfigurationMiss() {
+    QFETCH(bool, iniFormat);
+    QFETCH(int, keyCount);
+    populateStore(iniFormat, keyCount);
+    std::unique_ptr<ConfigurationService> service = createService(iniFormat);
+
+    QStringList keys;
+    for (int i = 0; i < kLookupsPerIteration; ++i) {
+        keys.append(QString("missing/key%1").arg(i));
+    }
+
+    QBENCHMARK {
+        for (const QString &key : std::as_const(keys)) {
+            bool exists = service->hasConfiguration(key);
+            Q_UNUSED(exists);
+        }
+    }
+}
+
+void BenchmarkConfigurationService::benchmarkGetAllKeys_data() {
+    addScaleRows();
+}
+
+void BenchmarkConfigurationService::benchmarkGetAllKeys() {
+    QFETCH(bool, iniFormat);
+    QFETCH(int, keyCount);
+    populateStore(iniFormat, keyCount);
+    std::unique_ptr<ConfigurationService> service = createService(iniFormat);
+
+    QBENCHMARK {
+        QStringList keys = service->getAllKeys();
+        Q_UNUSED(keys);
+    }
+}
+
+void BenchmarkConfigurationService::benchmarkSetConfigurationBurst_data() {
+    addScaleRows();
+}
+
+void BenchmarkConfigurationService::benchmarkSetConfigurationBurst() {
+    QFETCH(bool, iniFormat);
+    QFETCH(int, keyCount);
+    populateStore(iniFormat, keyCount);
+    std::unique_ptr<ConfigurationService> service = createService(iniFormat);
+
+    QStringList keys;
+    for (int i = 0; i < kLookupsPerIteration; ++i) {
+        keys.append(keyName(i * 7919 % keyCount));
+    }
+
+    // A new value every round so each write really changes the key
+    int round = 0;
+    QBENCHMARK {
+        ++round;
+        for (const QString &key : std::as_const(keys)) {
+            service->setConfiguration(key, round);
+        }
+    }
+}
+
+void BenchmarkConfigurationService::benchmarkSaveConfiguration_data() {
+    addScaleRows();
+}
+
+void BenchmarkConfigurationService::benchmarkSaveConfiguration() {
+    QFETCH(bool, iniFormat);
+    QFETCH(int, keyCount);
+    populateStore(iniFormat, keyCount);
+    std::unique_ptr<ConfigurationService> service = createService(iniFormat);
+
+    // One changed key per save, the common case after a user action
+    int round = 0;
+    QBENCHMARK {
+        service->setConfiguration("benchmark/round", ++round);
+        service->saveConfiguration();
+    }
+}
+
+QTEST_MAIN(BenchmarkConfigurationService)
+#include "benchmark_configuration_service.moc"
@@ -0,0 +1,79 @@
+#include <QCoreApplication>
+#include <QSettings>
+#include <QStandardPaths>
+#include <QtTest>
+#include "models/ApplicationModel.h"
+
+namespace {
+
+constexpr int kSavesPerIteration = 100;
+
+}  // namespace
+
+class BenchmarkModelAutosave : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    // Benchmark test cases
+    void benchmarkSaveSettings_data();
+    void benchmarkSaveSettings();
+};
+
+void BenchmarkModelAutosave::initTestCase() {
+    qDebug("Starting model autosave benchmarks");
+
+    // Keep the native store away from the real user configuration
+    QStandardPaths::setTestModeEnabled(true);
+    QCoreApplication::setOrganizationName("QtSimpleTemplateBenchmarks");
+    QCoreApplication::setApplicationName("benchmark_model_autosave");
+    QCoreApplication::setApplicationVersion("1.0.0");
+}
+
+void BenchmarkModelAutosave::cleanupTestCase() {
+    QSettings native;
+    native.clear();
+    native.sync();
+
+    qDebug("Finished model autosave benchmarks");
+}
+
+void BenchmarkModelAutosave::benchmarkSaveSettings_data() {
+    QTest::addColumn<int>("changesBetweenSaves");
+
+    // An autosave timer mostly fires on a model that has not changed
+    QTest::addRow("clean") << 0;
+    QTest::addRow("one change per save") << 1;
+    QTest::addRow("all persisted changed") << 2;
+}
+
+void BenchmarkModelAutosave::benchmarkSaveSettings() {
+    QFETCH(int, changesBetweenSaves);
+
+    ApplicationModel model;
+    QVERIFY(model.initialize());
+    QVERIFY(model.saveSettings());
+
+    static const QStringList themes = {"default", "dark", "light"};
+    int edit = 0;
+
+    QBENCHMARK {
+        for (int save = 0; save < kSavesPerIteration; ++save) {
+            ++edit;
+            if (changesBetweenSaves >= 1) {
+                model.setUserName(QString("user%1").arg(edit));
+            }
+            if (changesBetweenSaves >= 2) {
+                model.setTheme(themes.at(edit % themes.size()));
+            }
+            model.saveSettings();
+        }
+    }
+
+    QVERIFY(!model.isDirty(ApplicationModel::PROPERTY_USER_NAME));
+}
+
+QTEST_MAIN(BenchmarkModelAutosave)
+#include "benchmark_model_autosave.moc"
@@ -0,0 +1,117 @@
+#include <QCoreApplication>
+#include <QThread>
+#include <QtTest>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include "models/BaseModel.h"
+
+namespace {
+
+constexpr int kReadsPerThread = 100000;
+
+/**
+ * @brief Model with a handful of declared properties polled by readers
+ */
+class PolledModel : public BaseModel {
+public:
+    using Status = ModelProperty<QString, 0>;
+    using Progress = ModelProperty<int, 1>;
+    using Busy = ModelProperty<bool, 2>;
+
+    explicit PolledModel(QObject *parent = nullptr)
+        : BaseModel(propertyNames(), parent) {}
+
+private:
+    static const ModelPropertyTable &propertyNames() {
+        static const ModelPropertyTable table = {"status", "progress",
+                                                 "busy"};
+        return table;
+    }
+};
+
+}  // namespace
+
+class BenchmarkModelConcurrency : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    // Benchmark test cases
+    void benchmarkConcurrentReads_data();
+    void benchmarkConcurrentReads();
+};
+
+void BenchmarkModelConcurrency::initTestCase() {
+    qDebug("Starting model concurrency benchmarks");
+}
+
+void BenchmarkModelConcurrency::cleanupTestCase() {
+    qDebug("Finished model concurrency benchmarks");
+}
+
+void BenchmarkModelConcurrency::benchmarkConcurrentReads_data() {
+    QTest::addColumn<int>("readerCount");
+    QTest::addColumn<bool>("withWriter");
+
+    for (int readers : {1, 2, 4, 8, 16}) {
+        QTest::addRow("%d readers", readers) << readers << false;
+        QTest::addRow("%d readers + writer", readers) << readers << true;
+    }
+}
+
+void BenchmarkModelConcurrency::benchmarkConcurrentReads() {
+    QFETCH(int, readerCount);
+    QFETCH(bool, withWriter);
+
+    PolledModel model;
+    QVERIFY(model.initialize());
+    model.set<PolledModel::Status>(QString("Ready"));
+    model.set<PolledModel::Progress>(0);
+
+    // Every reader performs the same amount of work, so perfect scaling
+    // keeps the time constant as readers are added
+    QBENCHMARK {
+        std::atomic<bool> readersDone(false);
+        std::vector<std::unique_ptr<QThread>> threads;
+
+        for (int i = 0; i < readerCount; ++i) {
+            threads.emplace_back(QThread::create([&model]() {
+                int checksum = 0;
+                for (int read = 0; read < kReadsPerThread; ++read) {
+                    checksum += model.get<PolledModel::Progress>();
+                    checksum += model.getProperty("status").isValid();
+                }
+                Q_UNUSED(checksum);
+            }));
+        }
+
+        std::unique_ptr<QThread> writer;
+        if (withWriter) {
+            writer.reset(QThread::create([&model, &readersDone]() {
+                int progress = 0;
+                while (!readersDone.load(std::memory_order_relaxed)) {
+                    model.set<PolledModel::Progress>(++progress % 100);
+                }
+            }));
+            writer->start();
+        }
+
+        for (const auto &thread : threads) {
+            thread->start();
+        }
+        for (const auto &thread : threads) {
+            thread->wait();
+        }
+
+        readersDone.store(true, std::memory_order_relaxed);
+        if (writer) {
+            writer->wait();
+        }
+    }
+}
+
+QTEST_MAIN(BenchmarkModelConcurrency)
+#include "benchmark_model_concurrency.moc"
@@ -0,0 +1,278 @@
+#include <QCoreApplication>
+#include <QThread>
+#include <QtTest>
+#include <memory>
+#include <vector>
+#include "models/ApplicationModel.h"
+#include "models/BaseModel.h"
+
+namespace {
+
+constexpr int kWritesPerThread = 10000;
+
+// Writer w owns the properties whose index is w modulo this; property
+// counts used with the contention benchmark are multiples of it
+constexpr int kMaxWriters = 16;
+
+/**
+ * @brief Model populated with a configurable number of properties
+ */
+class SizedModel : public BaseModel {
+public:
+    explicit SizedModel(int propertyCount) {
+        m_names.reserve(propertyCount);
+        for (int i = 0; i < propertyCount; ++i) {
+            m_names.append(QString("property%1").arg(i));
+        }
+    }
+
+    // Shares the names of another model, so construction costs nothing
+    explicit SizedModel(const QStringList &names) : m_names(names) {}
+
+    const QStringList &names() const { return m_names; }
+
+protected:
+    bool initializeModel() override {
+        populate();
+        return true;
+    }
+
+    void resetModel() override { populate(); }
+
+private:
+    void populate() {
+        for (int i = 0; i < m_names.size(); ++i) {
+            setPropertySilent(m_names.at(i), i);
+        }
+    }
+
+    QStringList m_names;
+};
+
+void addPropertyCountRows() {
+    QTest::addColumn<int>("propertyCount");
+
+    for (int count : {10, 100, 1000, 10000, 100000}) {
+        QTest::addRow("%d properties", count) << count;
+    }
+}
+
+}  // namespace
+
+class BenchmarkModelPerformance : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    // Benchmark test cases
+    void benchmarkGetProperty_data();
+    void benchmarkGetProperty();
+    void benchmarkSetProperty_data();
+    void benchmarkSetProperty();
+    void benchmarkSetProperties_data();
+    void benchmarkSetProperties();
+    void benchmarkSingleChange_data();
+    void benchmarkSingleChange();
+    void benchmarkApplicationModelChange();
+    void benchmarkInitializeAndReset_data();
+    void benchmarkInitializeAndReset();
+    void benchmarkWriteContention_data();
+    void benchmarkWriteContention();
+};
+
+void BenchmarkModelPerformance::initTestCase() {
+    qDebug("Starting model performance benchmarks");
+
+    // ApplicationModel requires a name and version to be valid
+    QCoreApplication::setApplicationVersion("1.0.0");
+}
+
+void BenchmarkModelPerformance::cleanupTestCase() {
+    qDebug("Finished model performance benchmarks");
+}
+
+void BenchmarkModelPerformance::benchmarkGetProperty_data() {
+    addPropertyCountRows();
+}
+
+void BenchmarkModelPerformance::benchmarkGetProperty() {
+    QFETCH(int, propertyCount);
+
+    SizedModel model(propertyCount);
+    QVERIFY(model.initialize());
+    const QStringList &names = model.names();
+
+    // Reads every property once per iteration
+    QBENCHMARK {
+        qint64 checksum = 0;
+        for (const QString &name : names) {
+            checksum += model.getProperty(name).toInt();
+        }
+        Q_UNUSED(checksum);
+    }
+}
+
+void BenchmarkModelPerformance::benchmarkSetProperty_data() {
+    addPropertyCountRows();
+}
+
+void BenchmarkModelPerformance::benchmarkSetProperty() {
+    QFETCH(int, propertyCount);
+
+    SizedModel model(propertyCount);
+    QVERIFY(model.initialize());
+    const QStringList &names = model.names();
+    int round = 0;
+
+    // Writes a new value to every property once per iteration
+    QBENCHMARK {
+        ++round;
+        for (const QString &name : names) {
+            model.setProperty(name, round);
+        }
+    }
+}
+
+void BenchmarkModelPerformance::benchmarkSetProperties_data() {
+    addPropertyCountRows();
+}
+
+void BenchmarkModelPerformance::benchmarkSetProperties() {
+    QFETCH(int, propertyCount);
+
+    SizedModel model(propertyCount);
+    QVERIFY(model.initialize());
+
+    // Same work as benchmarkSetProperty, as one bulk assignment
+    QList<QVariantHash> batches(2);
+    for (int i = 0; i < propertyCount; ++i) {
+        batches[0].insert(model.names().at(i), -i);
+        batches[1].insert(model.names().at(i), i + 1);
+    }
+    int round = 0;
+
+    QBENCHMARK {
+        model.setProperties(batches.at(++round % 2));
+    }
+}
+
+void BenchmarkModelPerformance::benchmarkSingleChange_data() {
+    addPropertyCountRows();
+}
+
+void BenchmarkModelPerformance::benchmarkSingleChange() {
+    QFETCH(int, propertyCount);
+
+    SizedModel model(propertyCount);
+    QVERIFY(model.initialize());
+
+    // Listeners on all change signals, as views and controllers connect
+    int notifications = 0;
+    connect(&model, &IModel::propertyChanged,
+            [&notifications]() { ++notifications; });
+    connect(&model, &BaseModel::propertiesChanged,
+            [&notifications]() { ++notifications; });
+    connect(&model, &IModel::dataChanged,
+            [&notifications]() { ++notifications; });
+
+    const QString name = model.names().constLast();
+    int value = 0;
+
+    // One change: store, hooks and every notification it triggers
+    QBENCHMARK {
+        model.setProperty(name, ++value);
+    }
+    QVERIFY(notifications > 0);
+}
+
+void BenchmarkModelPerformance::benchmarkApplicationModelChange() {
+    ApplicationModel model;
+    QVERIFY(model.initialize());
+
+    int notifications = 0;
+    connect(&model, &IModel::propertyChanged,
+            [&notifications]() { ++notifications; });
+    connect(&model, &IModel::dataChanged,
+            [&notifications]() { ++notifications; });
+    connect(&model, &ApplicationModel::statusChanged,
+            [&notifications]() { ++notifications; });
+
+    int value = 0;
+
+    // Includes the property-specific signal and the validity check
+    QBENCHMARK {
+        model.setStatusMessage(QString::number(++value));
+    }
+    QVERIFY(notifications > 0);
+}
+
+void BenchmarkModelPerformance::benchmarkInitializeAndReset_data() {
+    addPropertyCountRows();
+}
+
+void BenchmarkModelPerformance::benchmarkInitializeAndReset() {
+    QFETCH(int, propertyCount);
+
+    const QStringList names = SizedModel(propertyCount).names();
+
+    // A fresh model per iteration, so that initialize() is measured too
+    QBENCHMARK {
+        SizedModel model(names);
+        QVERIFY(model.initialize());
+        model.reset();
+        QCOMPARE(model.getProperty(names.constLast()).toInt(),
+                 propertyCount - 1);
+    }
+}
+
+void BenchmarkModelPerformance::benchmarkWriteContention_data() {
+    QTest::addColumn<int>("propertyCount");
+    QTest::addColumn<int>("writerCount");
+
+    for (int count : {kMaxWriters, 100000}) {
+        for (int writers : {1, 2, 4, 8, kMaxWriters}) {
+            QTest::addRow("%d properties, %d writers", count, writers)
+                << count << writers;
+        }
+    }
+}
+
+void BenchmarkModelPerformance::benchmarkWriteContention() {
+    QFETCH(int, propertyCount);
+    QFETCH(int, writerCount);
+
+    SizedModel model(propertyCount);
+    QVERIFY(model.initialize());
+    const QStringList &names = model.names();
+
+    // Every writer performs the same amount of work on its own properties,
+    // so the time grows with the serialization the lock imposes. Indices
+    // stay congruent to the writer modulo kMaxWriters because the property
+    // count is a multiple of it, so no two writers share a property.
+    QCOMPARE(propertyCount % kMaxWriters, 0);
+    QBENCHMARK {
+        std::vector<std::unique_ptr<QThread>> threads;
+        for (int writer = 0; writer < writerCount; ++writer) {
+            threads.emplace_back(QThread::create([&model, &names, writer]() {
+                for (int write = 0; write < kWritesPerThread; ++write) {
+                    const QString &name =
+                        names.at((writer + write * kMaxWriters) %
+                                 names.size());
+                    model.setProperty(name, write);
+                }
+            }));
+        }
+
+        for (const auto &thread : threads) {
+            thread->start();
+        }
+        for (const auto &thread : threads) {
+            thread->wait();
+        }
+    }
+}
+
+QTEST_MAIN(BenchmarkModelPerformance)
+#include "benchmark_model_performance.moc"
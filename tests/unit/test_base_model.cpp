@@ -0,0 +1,726 @@
+#include <QCoreApplication>
+#include <QBuffer>
+#include <QSettings>
+#include <QSignalSpy>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QThread>
+#include <QtTest>
+#include "models/ApplicationModel.h"
+#include "models/BaseModel.h"
+#include "models/ModelRecorder.h"
+#include "models/ModelReplayer.h"
+#include "models/ModelSerializer.h"
+
+namespace {
+
+/**
+ * @brief Minimal model with two declared properties
+ */
+class TestModel : public BaseModel {
+public:
+    using Count = ModelProperty<int, 0>;
+    using Label = ModelProperty<QString, 1>;
+
+    explicit TestModel(QObject *parent = nullptr)
+        : BaseModel(propertyNames(), parent) {}
+
+    using BaseModel::addDerivedProperty;
+    using BaseModel::addValidator;
+    using BaseModel::getPropertyNames;
+    using BaseModel::hasProperty;
+
+    // Changes of this property are vetoed
+    QString vetoedProperty;
+
+protected:
+    bool beforePropertySet(const QString &propertyName,
+                           const QVariant &value) override {
+        return propertyName != vetoedProperty &&
+               BaseModel::beforePropertySet(propertyName, value);
+    }
+
+private:
+    static const ModelPropertyTable &propertyNames() {
+        static const ModelPropertyTable table = {"count", "label"};
+        return table;
+    }
+};
+
+}  // namespace
+
+class TestBaseModel : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    // Test cases
+    void testDeclaredPropertySlots();
+    void testStringApiForDeclaredAndDynamicProperties();
+    void testChangeSignals();
+    void testApplicationModelInitialization();
+    void testUpdateTransaction();
+    void testApplicationModelStatusUpdate();
+    void testIncrementalValidation();
+    void testUndoRedo();
+    void testUndoMergeAndMemoryLimit();
+    void testSnapshot();
+    void testSerializationRoundTrip();
+    void testSerializationSchemaEvolution();
+    void testDirtyTracking();
+    void testApplicationModelSavesOnlyChanges();
+    void testPropertySubscriptions();
+    void testMailboxCoalescesCrossThreadUpdates();
+    void testDerivedProperties();
+    void testRecordAndReplay();
+    void testSetPropertiesAllOrNothing();
+    void testStatusHistory();
+};
+
+void TestBaseModel::initTestCase() {
+    qDebug("Starting BaseModel tests");
+
+    // ApplicationModel requires a name and version to be valid
+    QCoreApplication::setApplicationVersion("1.0.0");
+
+    // Keep saved settings away from the real user configuration
+    QStandardPaths::setTestModeEnabled(true);
+    QCoreApplication::setOrganizationName("QtSimpleTemplateTests");
+}
+
+void TestBaseModel::cleanupTestCase() {
+    QSettings settings;
+    settings.clear();
+    settings.sync();
+
+    qDebug("Finished BaseModel tests");
+}
+
+void TestBaseModel::testDeclaredPropertySlots() {
+    TestModel model;
+    QVERIFY(model.initialize());
+
+    QCOMPARE(model.propertyTable().slot("count"), TestModel::Count::slot);
+    QCOMPARE(model.propertyTable().slot("label"), TestModel::Label::slot);
+    QCOMPARE(model.propertyTable().slot("other"), -1);
+    QCOMPARE(model.propertyTable().name(TestModel::Label::slot),
+             QString("label"));
+
+    QVERIFY(model.set<TestModel::Count>(42));
+    QCOMPARE(model.get<TestModel::Count>(), 42);
+    QCOMPARE(model.getProperty(TestModel::Count::slot), QVariant(42));
+    QCOMPARE(model.getProperty("count"), QVariant(42));
+}
+
+void TestBaseModel::testStringApiForDeclaredAndDynamicProperties() {
+    TestModel model;
+    QVERIFY(model.initialize());
+    QVERIFY(!model.hasProperty("label"));
+
+    // Declared properties set by name land in their slot
+    QVERIFY(model.setProperty("label", QString("text")));
+    QCOMPARE(model.get<TestModel::Label>(), QString("text"));
+    QVERIFY(model.hasProperty("label"));
+
+    // Undeclared properties keep working through the name API
+    QVERIFY(model.setProperty("dynamic", 3.5));
+    QCOMPARE(model.getProperty("dynamic").toDouble(), 3.5);
+    QVERIFY(model.hasProperty("dynamic"));
+
+    QStringList names = model.getPropertyNames();
+    names.sort();
+    QCOMPARE(names, QStringList({"dynamic", "label"}));
+
+    model.reset();
+    QVERIFY(model.getPropertyNames().isEmpty());
+}
+
+void TestBaseModel::testChangeSignals() {
+    TestModel model;
+    QVERIFY(model.initialize());
+
+    QSignalSpy propertySpy(&model, &IModel::propertyChanged);
+    QSignalSpy dataSpy(&model, &IModel::dataChanged);
+
+    QVERIFY(model.set<TestModel::Count>(1));
+    QCOMPARE(propertySpy.count(), 1);
+    QCOMPARE(propertySpy.at(0).at(0).toString(), QString("count"));
+    QCOMPARE(propertySpy.at(0).at(1), QVariant(1));
+    QCOMPARE(dataSpy.count(), 1);
+
+    // Setting the same value again is not a change
+    QVERIFY(model.set<TestModel::Count>(1));
+    QCOMPARE(propertySpy.count(), 1);
+}
+
+void TestBaseModel::testApplicationModelInitialization() {
+    ApplicationModel model;
+    QSignalSpy validitySpy(&model, &IModel::validityChanged);
+    QVERIFY(model.initialize());
+
+    QCOMPARE(model.getTheme(), QString("default"));
+    QCOMPARE(model.getStatusMessage(), QString("Ready"));
+    QCOMPARE(model.getProperty(ApplicationModel::PROPERTY_THEME),
+             QVariant(QString("default")));
+    QCOMPARE(validitySpy.count(), 1);
+
+    model.setTheme("dark");
+    QCOMPARE(model.get<ApplicationModel::Theme>(), QString("dark"));
+
+    // Invalid themes are rejected by the model
+    model.setTheme("neon");
+    QCOMPARE(model.getTheme(), QString("dark"));
+}
+
+void TestBaseModel::testUpdateTransaction() {
+    TestModel model;
+    QVERIFY(model.initialize());
+
+    QSignalSpy propertySpy(&model, &IModel::propertyChanged);
+    QSignalSpy batchSpy(&model, &BaseModel::propertiesChanged);
+    QSignalSpy dataSpy(&model, &IModel::dataChanged);
+    QSignalSpy validitySpy(&model, &IModel::validityChanged);
+
+    QVERIFY(model.applyUpdate(PropertyUpdate()
+                                  .set<TestModel::Count>(1)
+                                  .set<TestModel::Label>(QString("one"))
+                                  .set("dynamic", true)
+                                  .set<TestModel::Count>(2)));
+
+    // Every property is reported once, in one change set
+    QCOMPARE(batchSpy.count(), 1);
+    QCOMPARE(batchSpy.at(0).at(0).toStringList(),
+             QStringList({"count", "label", "dynamic"}));
+    QCOMPARE(propertySpy.count(), 3);
+    QCOMPARE(dataSpy.count(), 1);
+
+    // The model stayed valid, so there is no validity transition
+    QCOMPARE(validitySpy.count(), 0);
+    QCOMPARE(model.get<TestModel::Count>(), 2);
+
+    // A batch without real changes emits nothing
+    QVERIFY(model.applyUpdate(PropertyUpdate().set<TestModel::Count>(2)));
+    QCOMPARE(dataSpy.count(), 1);
+}
+
+void TestBaseModel::testApplicationModelStatusUpdate() {
+    ApplicationModel model;
+    QVERIFY(model.initialize());
+
+    QSignalSpy dataSpy(&model, &IModel::dataChanged);
+    QSignalSpy statusSpy(&model, &ApplicationModel::statusChanged);
+
+    // Derived values read from a handler already reflect the change
+    QCOMPARE(model.getWindowTitle(),
+             QCoreApplication::applicationName() + " 1.0.0 - Ready");
+    QString titleInHandler;
+    connect(&model, &ApplicationModel::statusChanged, this,
+            [&model, &titleInHandler]() {
+                titleInHandler = model.getWindowTitle();
+            });
+
+    model.updateStatus("Working");
+    QCOMPARE(dataSpy.count(), 1);
+    QCOMPARE(statusSpy.count(), 1);
+    QCOMPARE(titleInHandler,
+             QCoreApplication::applicationName() + " 1.0.0 - Working");
+    QCOMPARE(model.getStatusMessage(), QString("Working"));
+    QCOMPARE(model.getWindowTitle(),
+             QCoreApplication::applicationName() + " 1.0.0 - Working");
+}
+
+void TestBaseModel::testIncrementalValidation() {
+    TestModel model;
+    int checks = 0;
+    model.addValidator({"count"}, [&model, &checks]() {
+        ++checks;
+        return model.get<TestModel::Count>() > 0;
+    });
+
+    QSignalSpy validitySpy(&model, &IModel::validityChanged);
+    QVERIFY(model.initialize());
+    QVERIFY(!model.isValid());
+    QCOMPARE(checks, 1);
+    QCOMPARE(validitySpy.count(), 0);
+
+    // Only a change to a dependency re-runs the check
+    model.set<TestModel::Label>(QString("unrelated"));
+    QCOMPARE(checks, 1);
+    QCOMPARE(validitySpy.count(), 0);
+
+    model.set<TestModel::Count>(1);
+    QCOMPARE(checks, 2);
+    QCOMPARE(validitySpy.count(), 1);
+    QCOMPARE(validitySpy.at(0).at(0).toBool(), true);
+
+    // No transition, no signal
+    model.set<TestModel::Count>(2);
+    QCOMPARE(checks, 3);
+    QCOMPARE(validitySpy.count(), 1);
+    QVERIFY(model.isValid());
+    QCOMPARE(checks, 3);
+
+    model.set<TestModel::Count>(0);
+    QCOMPARE(validitySpy.count(), 2);
+    QCOMPARE(validitySpy.at(1).at(0).toBool(), false);
+
+    // Change handlers already see the validity after the change
+    QList<bool> seenValidity;
+    connect(&model, &IModel::dataChanged, &model,
+            [&model, &seenValidity]() {
+                seenValidity.append(model.isValid());
+            });
+    model.set<TestModel::Count>(3);
+    QCOMPARE(seenValidity, QList<bool>({true}));
+}
+
+void TestBaseModel::testUndoRedo() {
+    TestModel model;
+    QVERIFY(model.initialize());
+    model.setUndoEnabled(true);
+    model.setUndoMergeInterval(0);
+
+    model.set<TestModel::Count>(1);
+    model.applyUpdate(PropertyUpdate()
+                          .set<TestModel::Count>(2)
+                          .set<TestModel::Label>(QString("two"))
+                          .set("note", QString("dynamic")));
+    QVERIFY(model.canUndo());
+    QVERIFY(!model.canRedo());
+
+    // A transaction is undone as one step
+    QSignalSpy batchSpy(&model, &BaseModel::propertiesChanged);
+    QVERIFY(model.undo());
+    QCOMPARE(batchSpy.count(), 1);
+    QCOMPARE(model.get<TestModel::Count>(), 1);
+    QVERIFY(model.get<TestModel::Label>().isEmpty());
+    QVERIFY(!model.getProperty("note").isValid());
+
+    QVERIFY(model.redo());
+    QCOMPARE(model.get<TestModel::Count>(), 2);
+    QCOMPARE(model.getProperty("note").toString(), QString("dynamic"));
+
+    // A vetoed step is not applied and stays where it was
+    model.vetoedProperty = "label";
+    QVERIFY(!model.undo());
+    QCOMPARE(model.get<TestModel::Count>(), 2);
+    QVERIFY(model.canUndo());
+    QVERIFY(!model.canRedo());
+    model.vetoedProperty.clear();
+
+    QVERIFY(model.undo());
+    QVERIFY(model.undo());
+    QVERIFY(!model.canUndo());
+    QVERIFY(!model.getProperty("count").isValid());
+
+    // A new edit discards what could have been redone
+    QVERIFY(model.canRedo());
+    model.set<TestModel::Count>(5);
+    QVERIFY(!model.canRedo());
+    QVERIFY(!model.redo());
+}
+
+void TestBaseModel::testUndoMergeAndMemoryLimit() {
+    TestModel model;
+    QVERIFY(model.initialize());
+    model.setUndoEnabled(true);
+    model.setUndoMergeInterval(60 * 1000);
+
+    // Rapid edits of one property collapse into a single step
+    for (int count = 1; count <= 10; ++count) {
+        model.set<TestModel::Count>(count);
+    }
+    QVERIFY(model.undo());
+    QVERIFY(!model.canUndo());
+    QVERIFY(!model.getProperty("count").isValid());
+
+    // Only the newest history survives a small memory limit
+    model.setUndoMergeInterval(0);
+    model.setUndoMemoryLimit(512);
+    for (int count = 1; count <= 100; ++count) {
+        model.set<TestModel::Label>(QString(32, QChar('a' + count % 26)));
+    }
+    int steps = 0;
+    while (model.undo()) {
+        ++steps;
+    }
+    QVERIFY(steps > 0);
+    QVERIFY(steps < 100);
+    QVERIFY(!model.get<TestModel::Label>().isEmpty());
+
+    // Container payloads count toward the limit
+    model.clearUndoHistory();
+    model.setUndoMemoryLimit(4096);
+    model.setProperty("tags", QStringList(100, QString(64, QChar('x'))));
+    QVERIFY(!model.canUndo());
+}
+
+void TestBaseModel::testSnapshot() {
+    TestModel model;
+    QVERIFY(model.initialize());
+    model.set<TestModel::Count>(1);
+    model.setProperty("note", QString("first"));
+
+    const ModelSnapshot snapshot = model.snapshot();
+    QCOMPARE(snapshot.version(), model.version());
+    QCOMPARE(snapshot.get<TestModel::Count>(), 1);
+    QCOMPARE(snapshot.value("note").toString(), QString("first"));
+
+    // Later edits leave the snapshot untouched and make it stale
+    model.set<TestModel::Count>(2);
+    model.setProperty("note", QString("second"));
+    QVERIFY(snapshot.version() != model.version());
+    QCOMPARE(snapshot.get<TestModel::Count>(), 1);
+    QCOMPARE(snapshot.value("count").toInt(), 1);
+    QCOMPARE(snapshot.value("note").toString(), QString("first"));
+    QCOMPARE(snapshot.propertyNames(), QStringList({"count", "note"}));
+
+    // An unchanged value does not bump the version
+    const quint64 version = model.version();
+    model.set<TestModel::Count>(2);
+    QCOMPARE(model.version(), version);
+
+    QCOMPARE(ModelSnapshot().version(), quint64(0));
+}
+
+void TestBaseModel::testSerializationRoundTrip() {
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+    const QString filePath = tempDir.filePath("model.bin");
+
+    TestModel source;
+    QVERIFY(source.initialize());
+    source.applyUpdate(PropertyUpdate()
+                           .set<TestModel::Count>(42)
+                           .set<TestModel::Label>(QString("answer"))
+                           .set("ratio", 0.5));
+    QVERIFY(ModelSerializer::save(source, filePath));
+
+    TestModel restored;
+    QVERIFY(restored.initialize());
+    QSignalSpy batchSpy(&restored, &BaseModel::propertiesChanged);
+    QVERIFY(ModelSerializer::load(filePath, &restored));
+    QCOMPARE(batchSpy.count(), 1);
+    QCOMPARE(restored.get<TestModel::Count>(), 42);
+    QCOMPARE(restored.get<TestModel::Label>(), QString("answer"));
+    QCOMPARE(restored.getProperty("ratio").toDouble(), 0.5);
+
+    // Foreign or truncated data is rejected without touching the model
+    PropertyUpdate update;
+    QVERIFY(!ModelSerializer::read(QByteArray("not a model"), &update));
+
+    QBuffer buffer;
+    QVERIFY(buffer.open(QIODevice::WriteOnly));
+    QVERIFY(ModelSerializer::write(source.snapshot(), &buffer));
+    QVERIFY(!ModelSerializer::read(buffer.data().chopped(4), &update));
+}
+
+void TestBaseModel::testSerializationSchemaEvolution() {
+    // Data written by a model that kept everything as dynamic properties
+    BaseModel legacy;
+    QVERIFY(legacy.initialize());
+    legacy.setProperty("label", QString("legacy"));
+    legacy.setProperty("retired", true);
+
+    QBuffer buffer;
+    QVERIFY(buffer.open(QIODevice::WriteOnly));
+    QVERIFY(ModelSerializer::write(legacy.snapshot(), &buffer));
+
+    PropertyUpdate update;
+    QVERIFY(ModelSerializer::read(buffer.data(), &update));
+
+    // Properties are matched by name: declared ones land in their slots
+    TestModel model;
+    QVERIFY(model.initialize());
+    model.set<TestModel::Count>(7);
+    model.applyUpdate(update);
+    QCOMPARE(model.get<TestModel::Label>(), QString("legacy"));
+    QCOMPARE(model.get<TestModel::Count>(), 7);
+    QVERIFY(model.getProperty("retired").toBool());
+}
+
+void TestBaseModel::testDirtyTracking() {
+    TestModel model;
+    QVERIFY(model.initialize());
+    model.clearDirty();
+    QVERIFY(!model.isDirty());
+
+    model.set<TestModel::Count>(1);
+    model.setProperty("note", QString("dynamic"));
+    QVERIFY(model.isDirty());
+    QVERIFY(model.isDirty<TestModel::Count>());
+    QVERIFY(!model.isDirty<TestModel::Label>());
+    QCOMPARE(model.dirtyPropertyNames(), QStringList({"count", "note"}));
+
+    // Unchanged values stay clean
+    model.clearDirty();
+    model.set<TestModel::Count>(1);
+    QVERIFY(!model.isDirty());
+
+    model.set<TestModel::Count>(2);
+    QCOMPARE(model.takeDirty({"count", "label"}), QStringList({"count"}));
+    QVERIFY(!model.isDirty());
+
+    // Clearing the model is a change to everything it held
+    model.setProperty("note", QString("again"));
+    model.clearDirty();
+    model.reset();
+    QVERIFY(model.isDirty("note"));
+    QVERIFY(model.isDirty<TestModel::Label>());
+}
+
+void TestBaseModel::testApplicationModelSavesOnlyChanges() {
+    ApplicationModel model;
+    QVERIFY(model.initialize());
+    QVERIFY(model.loadSettings());
+    QVERIFY(!model.isDirty(ApplicationModel::PROPERTY_THEME));
+
+    model.setTheme("dark");
+    QVERIFY(model.isDirty(ApplicationModel::PROPERTY_THEME));
+    QVERIFY(!model.isDirty(ApplicationModel::PROPERTY_USER_NAME));
+
+    QSignalSpy savedSpy(&model, &ApplicationModel::settingsSaved);
+    QVERIFY(model.saveSettings());
+    QCOMPARE(savedSpy.count(), 1);
+    QVERIFY(!model.isDirty(ApplicationModel::PROPERTY_THEME));
+
+    QSettings settings;
+    QCOMPARE(settings.value("Application/theme").toString(), QString("dark"));
+
+    // A clean save still reports success
+    QVERIFY(model.saveSettings());
+    QCOMPARE(savedSpy.count(), 2);
+
+    // A stored value the model vetoes stays dirty and is replaced
+    settings.setValue("Application/theme", "unknown");
+    settings.sync();
+    ApplicationModel reloaded;
+    QVERIFY(reloaded.initialize());
+    QVERIFY(reloaded.loadSettings());
+    QCOMPARE(reloaded.getTheme(), QString("default"));
+    QVERIFY(reloaded.isDirty(ApplicationModel::PROPERTY_THEME));
+    QVERIFY(!reloaded.isDirty(ApplicationModel::PROPERTY_USER_NAME));
+    QVERIFY(reloaded.saveSettings());
+    settings.sync();
+    QCOMPARE(settings.value("Application/theme").toString(),
+             QString("default"));
+}
+
+void TestBaseModel::testPropertySubscriptions() {
+    TestModel model;
+    QVERIFY(model.initialize());
+
+    QList<int> counts;
+    const int id = model.subscribe<TestModel::Count>(
+        [&counts](const int &count) { counts.append(count); });
+
+    model.set<TestModel::Count>(1);
+    model.set<TestModel::Label>(QString("unrelated"));
+    model.setProperty("count", 2);
+
+    // Values of another type are converted to the declared one
+    model.setProperty("count", QString("3"));
+    QCOMPARE(counts, QList<int>({1, 2, 3}));
+
+    model.unsubscribe(id);
+    model.set<TestModel::Count>(4);
+    QCOMPARE(counts.size(), 3);
+}
+
+void TestBaseModel::testMailboxCoalescesCrossThreadUpdates() {
+    TestModel model;
+    QVERIFY(model.initialize());
+
+    QThread *notifyThread = nullptr;
+    model.subscribe<TestModel::Count>(
+        [&notifyThread](int) { notifyThread = QThread::currentThread(); });
+    QSignalSpy batchSpy(&model, &BaseModel::propertiesChanged);
+
+    QScopedPointer<QThread> producer(QThread::create([&model]() {
+        for (int count = 1; count <= 1000; ++count) {
+            model.post<TestModel::Count>(count);
+            model.postProperty("label", QString::number(count));
+        }
+    }));
+    producer->start();
+    QVERIFY(producer->wait());
+    QCOMPARE(batchSpy.count(), 0);
+
+    // Everything posted before the frame is applied as one change set,
+    // on the model's own thread
+    QTRY_COMPARE(model.get<TestModel::Count>(), 1000);
+    QCOMPARE(model.get<TestModel::Label>(), QString("1000"));
+    QCOMPARE(batchSpy.count(), 1);
+    QCOMPARE(notifyThread, QThread::currentThread());
+    QVERIFY(!model.drainMailbox());
+}
+
+void TestBaseModel::testDerivedProperties() {
+    TestModel model;
+    int computations = 0;
+    model.addDerivedProperty("parity", [&model, &computations]() {
+        ++computations;
+        return QVariant(model.get<TestModel::Count>() % 2 == 0 ? "even"
+                                                               : "odd");
+    });
+    QVERIFY(model.initialize());
+    model.set<TestModel::Count>(2);
+
+    QCOMPARE(model.getProperty("parity").toString(), QString("even"));
+    QCOMPARE(model.getProperty("parity").toString(), QString("even"));
+    QCOMPARE(computations, 1);
+
+    QSignalSpy changeSpy(&model, &IModel::propertyChanged);
+
+    // Unrelated inputs leave the cached value alone
+    model.set<TestModel::Label>(QString("unrelated"));
+    model.getProperty("parity");
+    QCOMPARE(computations, 1);
+
+    // A change of an input that does not change the value is not reported
+    model.set<TestModel::Count>(4);
+    QCoreApplication::processEvents();
+    QCOMPARE(computations, 2);
+    QCOMPARE(changeSpy.count(), 2);
+
+    model.set<TestModel::Count>(5);
+    QTRY_COMPARE(changeSpy.count(), 4);
+    QCOMPARE(changeSpy.at(3).at(0).toString(), QString("parity"));
+    QCOMPARE(changeSpy.at(3).at(1).toString(), QString("odd"));
+
+    QVERIFY(!model.setProperty("parity", QString("even")));
+}
+
+void TestBaseModel::testRecordAndReplay() {
+    QBuffer recording;
+    QVERIFY(recording.open(QIODevice::WriteOnly));
+
+    TestModel source;
+    QVERIFY(source.initialize());
+    ModelRecorder recorder(&recording);
+    source.setRecorder(&recorder);
+    source.set<TestModel::Count>(1);
+    QTest::qWait(20);
+    source.applyUpdate(PropertyUpdate()
+                           .set<TestModel::Count>(2)
+                           .set<TestModel::Label>(QString("two")));
+    source.setProperty("note", QString("dynamic"));
+    source.setRecorder(nullptr);
+    source.set<TestModel::Count>(3);
+    QCOMPARE(recorder.recordCount(), 3);
+    QVERIFY(recorder.isOk());
+    recording.close();
+
+    // Change sets are replayed as they were made
+    for (ModelReplayer::Mode mode :
+         {ModelReplayer::AsFastAsPossible, ModelReplayer::RealTime}) {
+        QVERIFY(recording.open(QIODevice::ReadOnly));
+        TestModel target;
+        QVERIFY(target.initialize());
+        QSignalSpy batchSpy(&target, &BaseModel::propertiesChanged);
+
+        ModelReplayer replayer(&recording, &target);
+        QSignalSpy finishedSpy(&replayer, &ModelReplayer::finished);
+        QVERIFY(replayer.start(mode));
+        QTRY_COMPARE(finishedSpy.count(), 1);
+        QVERIFY(finishedSpy.at(0).at(0).toBool());
+
+        QCOMPARE(replayer.replayedCount(), 3);
+        QCOMPARE(batchSpy.count(), 3);
+        QCOMPARE(target.get<TestModel::Count>(), 2);
+        QCOMPARE(target.get<TestModel::Label>(), QString("two"));
+        QCOMPARE(target.getProperty("note").toString(), QString("dynamic"));
+        recording.close();
+    }
+
+    // A slot outside the model's table marks the recording as corrupt
+    QBuffer corrupt;
+    QVERIFY(corrupt.open(QIODevice::WriteOnly));
+    QDataStream out(&corrupt);
+    out.setVersion(ModelRecorder::StreamVersion);
+    out << ModelRecorder::Magic << ModelRecorder::FormatVersion << qint64(0)
+        << quint32(1) << qint32(1000) << QVariant(1);
+    corrupt.close();
+    QVERIFY(corrupt.open(QIODevice::ReadOnly));
+
+    TestModel target;
+    QVERIFY(target.initialize());
+    ModelReplayer replayer(&corrupt, &target);
+    QSignalSpy finishedSpy(&replayer, &ModelReplayer::finished);
+    QVERIFY(replayer.start(ModelReplayer::AsFastAsPossible));
+    QCOMPARE(finishedSpy.count(), 1);
+    QVERIFY(!finishedSpy.at(0).at(0).toBool());
+    QCOMPARE(replayer.replayedCount(), 0);
+}
+
+void TestBaseModel::testSetPropertiesAllOrNothing() {
+    ApplicationModel model;
+    QVERIFY(model.initialize());
+
+    QSignalSpy batchSpy(&model, &BaseModel::propertiesChanged);
+    QSignalSpy dataSpy(&model, &IModel::dataChanged);
+
+    // One invalid value rejects the whole batch
+    QVERIFY(!model.setProperties({{ApplicationModel::PROPERTY_USER_NAME,
+                                   QString("alice")},
+                                  {ApplicationModel::PROPERTY_THEME,
+                                   QString("unknown")}}));
+    QVERIFY(model.getUserName().isEmpty());
+    QCOMPARE(model.getTheme(), QString("default"));
+    QCOMPARE(batchSpy.count(), 0);
+
+    QVERIFY(model.setProperties({{ApplicationModel::PROPERTY_USER_NAME,
+                                  QString("alice")},
+                                 {ApplicationModel::PROPERTY_THEME,
+                                  QString("dark")},
+                                 {"custom", 1}}));
+    QCOMPARE(model.getUserName(), QString("alice"));
+    QCOMPARE(model.getTheme(), QString("dark"));
+    QCOMPARE(model.getProperty("custom").toInt(), 1);
+    QCOMPARE(batchSpy.count(), 1);
+    QCOMPARE(batchSpy.at(0).at(0).toStringList().size(), 3);
+    QCOMPARE(dataSpy.count(), 1);
+}
+
+void TestBaseModel::testStatusHistory() {
+    StatusHistory history(3);
+    history.record("Ready", 1);
+    history.record("Saving", 2);
+    history.record("Ready", 3);
+    QCOMPARE(history.poolSize(), 2);
+
+    // The oldest entry makes room; its message stays while still used
+    history.record("Ready", 4);
+    QCOMPARE(history.size(), 3);
+    QCOMPARE(history.poolSize(), 2);
+    history.record("Done", 5);
+    QCOMPARE(history.poolSize(), 2);
+
+    const QList<StatusHistory::Entry> entries = history.entries();
+    QCOMPARE(entries.size(), 3);
+    QCOMPARE(entries.at(0).timestamp, qint64(3));
+    QCOMPARE(entries.at(2).message, QString("Done"));
+
+    history.setCapacity(2);
+    QCOMPARE(history.entries().first().timestamp, qint64(4));
+    history.setCapacity(1);
+    QCOMPARE(history.poolSize(), 1);
+    QCOMPARE(history.entries().first().message, QString("Done"));
+    history.record("Ready", 6);
+    QCOMPARE(history.entries().first().message, QString("Ready"));
+
+    // ApplicationModel records every updateStatus() call
+    ApplicationModel model;
+    QVERIFY(model.initialize());
+    model.setStatusHistoryCapacity(2);
+    model.updateStatus("Ready");
+    model.updateStatus("Ready");
+    model.updateStatus("Working");
+    QCOMPARE(model.getStatusHistory().size(), 2);
+    QCOMPARE(model.getStatusHistory().last().message, QString("Working"));
+}
+
+QTEST_MAIN(TestBaseModel)
+#include "test_base_model.moc"
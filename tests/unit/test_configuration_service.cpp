@@ -0,0 +1,649 @@
+#include <QCoreApplication>
+#include <QTemporaryDir>
+#include <QThread>
+#include <QtTest>
+#include <atomic>
+#include "services/ConfigurationService.h"
+
+class TestConfigurationService : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void init();
+    void cleanup();
+
+    // Test cases
+    void testSetAndGet();
+    void testSnapshotVersioning();
+    void testSnapshotIsImmutable();
+    void testConcurrentSnapshotReads();
+    void testKeyIndexQueries();
+    void testKeyIndexRangeIteration();
+    void testSubscriptionsByKeyAndGroup();
+    void testSubscriptionLifetime();
+    void testQueuedSubscriptionDelivery();
+    void testLayerPrecedence();
+    void testLayerReloadNotifiesOnlyChangedKeys();
+    void testEnvironmentAndCommandLineLayers();
+    void testSchemaValidation();
+    void testSharedSystemLayer();
+    void testProfileSwitching();
+    void testAsyncSave();
+    void testShutdownBarrier();
+    void testJournalReplay();
+    void testJournalTornTailRecovery();
+    void testJournalCompaction();
+
+private:
+    QTemporaryDir *tempDir;
+    ConfigurationService *service;
+};
+
+void TestConfigurationService::initTestCase() {
+    qDebug("Starting ConfigurationService tests");
+}
+
+void TestConfigurationService::cleanupTestCase() {
+    qDebug("Finished ConfigurationService tests");
+}
+
+void TestConfigurationService::init() {
+    tempDir = new QTemporaryDir();
+    QVERIFY(tempDir->isValid());
+
+    service = new ConfigurationService();
+    service->setConfigurationFile(tempDir->filePath("config.ini"));
+    QVERIFY(service->initialize());
+    QVERIFY(service->start());
+}
+
+void TestConfigurationService::cleanup() {
+    service->stop();
+    delete service;
+    service = nullptr;
+
+    delete tempDir;
+    tempDir = nullptr;
+}
+
+void TestConfigurationService::testSetAndGet() {
+    QVERIFY(service->setConfiguration("test/value", 42));
+    QCOMPARE(service->getConfiguration("test/value").toInt(), 42);
+    QVERIFY(service->hasConfiguration("test/value"));
+
+    QVERIFY(service->removeConfiguration("test/value"));
+    QVERIFY(!service->hasConfiguration("test/value"));
+    QCOMPARE(service->getConfiguration("test/value", 7).toInt(), 7);
+}
+
+void TestConfigurationService::testSnapshotVersioning() {
+    ConfigurationSnapshotPtr before = service->snapshot();
+    QVERIFY(before != nullptr);
+
+    service->setConfiguration("test/a", 1);
+    service->setConfiguration("test/b", 2);
+
+    // Writes on the owner thread are visible in the next snapshot
+    ConfigurationSnapshotPtr after = service->snapshot();
+    QVERIFY(after->version() > before->version());
+    QCOMPARE(after->value("test/a").toInt(), 1);
+    QCOMPARE(after->value("test/b").toInt(), 2);
+
+    // Without further writes the same snapshot is returned
+    QCOMPARE(service->snapshot().get(), after.get());
+}
+
+void TestConfigurationService::testSnapshotIsImmutable() {
+    service->setConfiguration("test/value", "old");
+    service->setConfiguration("test/other", "other");
+    ConfigurationSnapshotPtr old = service->snapshot();
+
+    service->setConfiguration("test/value", "new");
+    service->removeConfiguration("test/other");
+
+    QCOMPARE(old->value("test/value").toString(), QString("old"));
+    QVERIFY(old->contains("test/other"));
+    QCOMPARE(service->snapshot()->value("test/value").toString(),
+             QString("new"));
+}
+
+void TestConfigurationService::testConcurrentSnapshotReads() {
+    service->setConfiguration("test/counter", 0);
+    service->publishSnapshot();
+
+    std::atomic<bool> stop(false);
+    std::atomic<int> inconsistencies(0);
+    QList<QThread *> readers;
+
+    for (int i = 0; i < 4; ++i) {
+        readers.append(QThread::create([&]() {
+            while (!stop.load()) {
+                ConfigurationSnapshotPtr snap = service->snapshot();
+                // Both keys are written together before each publish
+                if (snap->value("test/counter") != snap->value("test/mirror") &&
+                    snap->contains("test/mirror")) {
+                    ++inconsistencies;
+                }
+                service->getConfiguration("test/counter");
+            }
+        }));
+        readers.last()->start();
+    }
+
+    for (int i = 1; i <= 1000; ++i) {
+        service->setConfiguration("test/counter", i);
+        service->setConfiguration("test/mirror", i);
+        service->publishSnapshot();
+    }
+
+    stop.store(true);
+    for (QThread *reader : readers) {
+        QVERIFY(reader->wait(5000));
+        delete reader;
+    }
+
+    QCOMPARE(inconsistencies.load(), 0);
+    QCOMPARE(service->snapshot()->value("test/counter").toInt(), 1000);
+}
+
+void TestConfigurationService::testKeyIndexQueries() {
+    service->setConfiguration("window/width", 800);
+    service->setConfiguration("window/geometry/x", 10);
+    service->setConfiguration("window/geometry/y", 20);
+    service->setConfiguration("window/state/maximized", true);
+    service->setConfiguration("windowing/mode", "tiled");
+
+    // "window" must not match the sibling group "windowing"
+    const QStringList keys = service->keysUnder("window");
+    QVERIFY(keys.contains("window/geometry/x"));
+    QVERIFY(keys.contains("window/width"));
+    QVERIFY(!keys.contains("windowing/mode"));
+    QCOMPARE(service->keysUnder("window/"), keys);
+
+    QCOMPARE(service->childGroups("window"),
+             QStringList({"geometry", "state"}));
+    QVERIFY(service->childKeys("window").contains("width"));
+    QVERIFY(!service->childKeys("window").contains("geometry"));
+    QVERIFY(service->childGroups(QString()).contains("windowing"));
+
+    service->removeConfiguration("window/state/maximized");
+    QCOMPARE(service->childGroups("window"), QStringList({"geometry"}));
+
+    // getAllKeys() is sorted and free of duplicates
+    const QStringList all = service->getAllKeys();
+    QStringList sorted = all;
+    sorted.sort();
+    QCOMPARE(all, sorted);
+    QCOMPARE(all.size(), QSet<QString>(all.begin(), all.end()).size());
+}
+
+void TestConfigurationService::testKeyIndexRangeIteration() {
+    for (int i = 0; i < 10; ++i) {
+        service->setConfiguration(QString("documents/%1/path").arg(i), i);
+    }
+
+    ConfigurationKeyIndex index = service->keyIndex();
+    int count = 0;
+    for (const QString &key : index.range("documents")) {
+        QVERIFY(key.startsWith("documents/"));
+        ++count;
+    }
+    QCOMPARE(count, 10);
+    QVERIFY(index.range("missing").isEmpty());
+
+    // The copy is unaffected by later writes
+    service->setConfiguration("documents/99/path", 99);
+    QCOMPARE(index.keysUnder("documents").size(), 10);
+    QCOMPARE(service->keysUnder("documents").size(), 11);
+}
+
+void TestConfigurationService::testSubscriptionsByKeyAndGroup() {
+    QStringList exactHits;
+    QStringList groupHits;
+    QStringList allHits;
+
+    service->subscribe("window/width", nullptr,
+                       [&](const QString &key, const QVariant &) {
+                           exactHits.append(key);
+                       });
+    service->subscribe("window/", nullptr,
+                       [&](const QString &key, const QVariant &) {
+                           groupHits.append(key);
+                       });
+    const int allId = service->subscribe(
+        QString(), nullptr,
+        [&](const QString &key, const QVariant &) { allHits.append(key); });
+
+    service->setConfiguration("window/width", 640);
+    service->setConfiguration("window/geometry/x", 5);
+    service->setConfiguration("windowing/mode", "tiled");
+    service->removeConfiguration("window/width");
+
+    QCOMPARE(exactHits, QStringList({"window/width", "window/width"}));
+    QCOMPARE(groupHits, QStringList({"window/width", "window/geometry/x",
+                                     "window/width"}));
+    QCOMPARE(allHits.size(), 4);
+
+    // Clearing reports each removed key the subscription covers
+    service->unsubscribe(allId);
+    groupHits.clear();
+    service->clearConfiguration();
+    QVERIFY(groupHits.contains("window/geometry/x"));
+    QVERIFY(!groupHits.contains("windowing/mode"));
+    QCOMPARE(allHits.size(), 4);
+}
+
+void TestConfigurationService::testSubscriptionLifetime() {
+    int calls = 0;
+    QObject *context = new QObject();
+    service->subscribe("test/", context,
+                       [&](const QString &, const QVariant &) { ++calls; });
+
+    service->setConfiguration("test/value", 1);
+    QCOMPARE(calls, 1);
+
+    delete context;
+    service->setConfiguration("test/value", 2);
+    QCOMPARE(calls, 1);
+}
+
+void TestConfigurationService::testQueuedSubscriptionDelivery() {
+    QThread worker;
+    QObject *receiver = new QObject();
+    receiver->moveToThread(&worker);
+    connect(&worker, &QThread::finished, receiver, &QObject::deleteLater);
+    worker.start();
+
+    std::atomic<QThread *> deliveredOn(nullptr);
+    std::atomic<int> deliveredValue(0);
+    service->subscribe("test/value", receiver,
+                       [&](const QString &, const QVariant &value) {
+                           deliveredValue.store(value.toInt());
+                           deliveredOn.store(QThread::currentThread());
+                       });
+
+    service->setConfiguration("test/value", 42);
+    QTRY_VERIFY(deliveredOn.load() != nullptr);
+    QCOMPARE(deliveredOn.load(), &worker);
+    QCOMPARE(deliveredValue.load(), 42);
+
+    worker.quit();
+    QVERIFY(worker.wait(5000));
+}
+
+void TestConfigurationService::testLayerPrecedence() {
+    // Defaults are served without being written to the user store
+    QCOMPARE(service->getConfiguration("window/width").toInt(), 1000);
+    QCOMPARE(service->effectiveLayer("window/width"),
+             ConfigurationService::DefaultsLayer);
+    QVERIFY(!service->layer(ConfigurationService::UserLayer)
+                 .contains("window/width"));
+
+    service->setConfiguration("window/width", 1200);
+    QCOMPARE(service->getConfiguration("window/width").toInt(), 1200);
+
+    QVERIFY(service->setLayer(ConfigurationService::CommandLineLayer,
+                              {{"window/width", 1600}}));
+    QCOMPARE(service->getConfiguration("window/width").toInt(), 1600);
+    QCOMPARE(service->effectiveLayer("window/width"),
+             ConfigurationService::CommandLineLayer);
+
+    // User writes below an override do not change the effective value
+    QSignalSpy spy(service, &IService::configurationChanged);
+    service->setConfiguration("window/width", 1300);
+    QCOMPARE(spy.count(), 0);
+    QCOMPARE(service->getConfiguration("window/width").toInt(), 1600);
+
+    // Removing layers reveals the next one down
+    service->setLayer(ConfigurationService::CommandLineLayer, {});
+    QCOMPARE(service->getConfiguration("window/width").toInt(), 1300);
+    service->removeConfiguration("window/width");
+    QCOMPARE(service->getConfiguration("window/width").toInt(), 1000);
+
+    QVERIFY(!service->setLayer(ConfigurationService::UserLayer, {}));
+}
+
+void TestConfigurationService::testLayerReloadNotifiesOnlyChangedKeys() {
+    QHash<QString, QVariant> system;
+    for (int i = 0; i < 100; ++i) {
+        system.insert(QString("system/key%1").arg(i), i);
+    }
+    service->setLayer(ConfigurationService::SystemLayer, system);
+
+    QSignalSpy spy(service, &IService::configurationChanged);
+    system.insert("system/key7", 700);
+    system.remove("system/key8");
+    service->setLayer(ConfigurationService::SystemLayer, system);
+
+    QCOMPARE(spy.count(), 2);
+    QCOMPARE(service->getConfiguration("system/key7").toInt(), 700);
+    QVERIFY(!service->hasConfiguration("system/key8"));
+    QCOMPARE(service->keysUnder("system").size(), 99);
+}
+
+void TestConfigurationService::testEnvironmentAndCommandLineLayers() {
+    qputenv("QSTTEST_application__language", "de");
+    service->loadEnvironment("QSTTEST_");
+    qunsetenv("QSTTEST_application__language");
+    QCOMPARE(service->getConfiguration("application/language").toString(),
+             QString("de"));
+
+    service->loadCommandLine({"app", "--config", "application/language=fr",
+                              "--verbose", "--config=window/height=480"});
+    QCOMPARE(service->getConfiguration("application/language").toString(),
+             QString("fr"));
+    QCOMPARE(service->getConfiguration("window/height").toInt(), 480);
+    QCOMPARE(service->effectiveLayer("window/height"),
+             ConfigurationService::CommandLineLayer);
+}
+
+void TestConfigurationService::testSchemaValidation() {
+    // Defaults come from the schema with their declared types
+    QCOMPARE(service->getConfiguration("window/width").typeId(),
+             QMetaType::Int);
+    QCOMPARE(service->getConfiguration("window/maximized").typeId(),
+             QMetaType::Bool);
+
+    // Out of range or unconvertible values are rejected
+    QVERIFY(!service->setConfiguration("window/width", 50));
+    QVERIFY(!service->setConfiguration("window/height", "tall"));
+    QCOMPARE(service->getConfiguration("window/width").toInt(), 1000);
+    QCOMPARE(service->getConfiguration("window/height").toInt(), 700);
+
+    // Convertible values are stored with the schema type
+    QVERIFY(service->setConfiguration("window/width", "800"));
+    QCOMPARE(service->getConfiguration("window/width"), QVariant(800));
+
+    // Keys outside the schema are stored as they are
+    QVERIFY(service->setConfiguration("test/free", "anything"));
+    QCOMPARE(service->getConfiguration("test/free").toString(),
+             QString("anything"));
+
+    // Invalid values from other layers are dropped
+    service->loadCommandLine({"app", "--config", "window/height=tall",
+                              "--config", "window/maximized=true"});
+    QCOMPARE(service->getConfiguration("window/height").toInt(), 700);
+    QCOMPARE(service->getConfiguration("window/maximized"), QVariant(true));
+
+    // Values read back from the INI file regain their types
+    QVERIFY(service->saveConfiguration());
+    QVERIFY(service->loadConfiguration());
+    QCOMPARE(service->layer(ConfigurationService::UserLayer)
+                 .value("window/width"),
+             QVariant(800));
+}
+
+void TestConfigurationService::testSharedSystemLayer() {
+    const QString systemFile = tempDir->filePath("system.ini");
+    {
+        QSettings system(systemFile, QSettings::IniFormat);
+        system.setValue("application/theme", "dark");
+    }
+
+    // The first instance parses the file and publishes it
+    service->setSystemLayerSharingEnabled(true);
+    QVERIFY(service->loadSystemConfiguration(systemFile));
+    QCOMPARE(service->sharedSystemLayerVersion(), quint64(1));
+
+    // A second instance maps the published layer
+    ConfigurationService other;
+    other.setConfigurationFile(tempDir->filePath("other.ini"));
+    QVERIFY(other.initialize());
+    other.setSystemLayerSharingEnabled(true);
+    QVERIFY(other.loadSystemConfiguration(systemFile));
+    QCOMPARE(other.sharedSystemLayerVersion(), quint64(1));
+    QCOMPARE(other.getConfiguration("application/theme").toString(),
+             QString("dark"));
+
+    // User layers stay private to each instance
+    other.setConfiguration("application/theme", "light");
+    QCOMPARE(service->getConfiguration("application/theme").toString(),
+             QString("dark"));
+
+    // A changed file is parsed again and re-published
+    {
+        QSettings system(systemFile, QSettings::IniFormat);
+        system.setValue("application/language", "de");
+    }
+    QVERIFY(other.loadSystemConfiguration(systemFile));
+    QCOMPARE(other.sharedSystemLayerVersion(), quint64(2));
+    QVERIFY(service->loadSystemConfiguration(systemFile));
+    QCOMPARE(service->sharedSystemLayerVersion(), quint64(2));
+    QCOMPARE(service->getConfiguration("application/language").toString(),
+             QString("de"));
+
+    // A file that outgrows the segment moves to a larger one
+    const QString large(128 * 1024, QLatin1Char('x'));
+    {
+        QSettings system(systemFile, QSettings::IniFormat);
+        system.setValue("test/large", large);
+    }
+    QVERIFY(other.loadSystemConfiguration(systemFile));
+    QCOMPARE(other.sharedSystemLayerVersion(), quint64(3));
+    QVERIFY(service->loadSystemConfiguration(systemFile));
+    QCOMPARE(service->sharedSystemLayerVersion(), quint64(3));
+    QCOMPARE(service->getConfiguration("test/large").toString(), large);
+}
+
+void TestConfigurationService::testProfileSwitching() {
+    const QString profileFile = tempDir->filePath("capture.ini");
+    {
+        QSettings profile(profileFile, QSettings::IniFormat);
+        profile.setValue("window/width", 1200);
+        profile.setValue("application/theme", "dark");
+    }
+    QVERIFY(service->loadProfile("capture", profileFile));
+    service->addProfile("analysis", {{"window/width", 1200},
+                                     {"window/height", 900},
+                                     {"application/theme", "light"}});
+    QCOMPARE(service->profiles(), QStringList({"analysis", "capture"}));
+    QVERIFY(!service->setActiveProfile("review"));
+
+    QVERIFY(service->setActiveProfile("capture"));
+    QCOMPARE(service->getConfiguration("window/width"), QVariant(1200));
+    QCOMPARE(service->effectiveLayer("window/width"),
+             ConfigurationService::ProfileLayer);
+
+    // Only keys that differ between the profiles are notified, in one batch
+    QSignalSpy switched(service, &ConfigurationService::activeProfileChanged);
+    QSignalSpy changed(service, &IService::configurationChanged);
+    QVERIFY(service->setActiveProfile("analysis"));
+    QCOMPARE(switched.count(), 1);
+    QStringList changedKeys = switched.at(0).at(1).toStringList();
+    changedKeys.sort();
+    QCOMPARE(changedKeys,
+             QStringList({"application/theme", "window/height"}));
+    QCOMPARE(changed.count(), 2);
+
+    // The user layer still overrides the profile
+    service->setConfiguration("application/theme", "custom");
+    QVERIFY(service->setActiveProfile("capture"));
+    QCOMPARE(service->getConfiguration("application/theme").toString(),
+             QString("custom"));
+    QCOMPARE(service->getConfiguration("window/height").toInt(), 700);
+
+    // Deactivating falls back to the layers below
+    QVERIFY(service->setActiveProfile(QString()));
+    QCOMPARE(service->getConfiguration("window/width").toInt(), 1000);
+    QVERIFY(service->removeProfile("capture"));
+    QCOMPARE(service->profiles(), QStringList("analysis"));
+}
+
+void TestConfigurationService::testAsyncSave() {
+    QSignalSpy finished(service,
+                        &ConfigurationService::configurationSaveFinished);
+    QSignalSpy saved(service, &ConfigurationService::configurationSaved);
+
+    service->setConfiguration("test/value", 1);
+    service->saveConfigurationAsync();
+    service->setConfiguration("test/value", 2);
+    service->saveConfigurationAsync();
+    service->setConfiguration("test/value", 3);
+    service->saveConfigurationAsync();
+
+    // Superseded saves complete together with the one that replaced them
+    QVERIFY(service->waitForPendingSaves(5000));
+    QTRY_COMPARE(finished.count(), 3);
+    QVERIFY(saved.count() >= 1);
+    QVERIFY(finished.last().at(0).toBool());
+
+    // The newest snapshot wins and no temporary files are left behind
+    QSettings written(tempDir->filePath("config.ini"), QSettings::IniFormat);
+    QCOMPARE(written.value("test/value").toInt(), 3);
+    QVERIFY(!written.contains("window/width"));
+    QCOMPARE(QDir(tempDir->path())
+                 .entryList(QDir::Files | QDir::Hidden),
+             QStringList("config.ini"));
+
+    // A synchronous save after a background one keeps removed keys removed
+    QVERIFY(service->removeConfiguration("test/value"));
+    QVERIFY(service->saveConfiguration());
+    QSettings rewritten(tempDir->filePath("config.ini"), QSettings::IniFormat);
+    QVERIFY(!rewritten.contains("test/value"));
+}
+
+void TestConfigurationService::testShutdownBarrier() {
+    service->setConfiguration("test/value", "persisted");
+    service->removeConfiguration("test/value");
+    service->setConfiguration("test/other", "persisted");
+
+    // stop() waits for the final save before returning
+    service->stop();
+
+    QSettings written(tempDir->filePath("config.ini"), QSettings::IniFormat);
+    QVERIFY(!written.contains("test/value"));
+    QCOMPARE(written.value("test/other").toString(), QString("persisted"));
+
+    // A fresh service sees the saved state
+    ConfigurationService reloaded;
+    reloaded.setConfigurationFile(tempDir->filePath("config.ini"));
+    QVERIFY(reloaded.initialize());
+    QCOMPARE(reloaded.getConfiguration("test/other").toString(),
+             QString("persisted"));
+
+    // Destroying a service without stop() still writes debounced changes
+    {
+        ConfigurationService unstopped;
+        unstopped.setConfigurationFile(tempDir->filePath("config.ini"));
+        QVERIFY(unstopped.initialize());
+        QVERIFY(unstopped.start());
+        unstopped.setConfiguration("test/other", "destroyed");
+    }
+    QSettings rewritten(tempDir->filePath("config.ini"), QSettings::IniFormat);
+    QCOMPARE(rewritten.value("test/other").toString(), QString("destroyed"));
+}
+
+void TestConfigurationService::testJournalReplay() {
+    const QString journalDir = tempDir->filePath("journal");
+    service->setConfiguration("test/seeded", "before");
+    QVERIFY(service->setJournalDirectory(journalDir));
+    QCOMPARE(service->getJournalDirectory(), journalDir);
+
+    service->setConfiguration("test/value", "journaled");
+    service->setConfiguration("test/removed", 1);
+    service->removeConfiguration("test/removed");
+    service->stop();
+
+    ConfigurationService reloaded;
+    reloaded.setConfigurationFile(tempDir->filePath("config.ini"));
+    QVERIFY(reloaded.initialize());
+    QVERIFY(reloaded.setJournalDirectory(journalDir));
+    QCOMPARE(reloaded.getConfiguration("test/seeded").toString(),
+             QString("before"));
+    QCOMPARE(reloaded.getConfiguration("test/value").toString(),
+             QString("journaled"));
+    QVERIFY(!reloaded.hasConfiguration("test/removed"));
+}
+
+void TestConfigurationService::testJournalTornTailRecovery() {
+    const QString journalDir = tempDir->filePath("journal");
+    QVERIFY(service->setJournalDirectory(journalDir));
+    service->setConfiguration("test/value", "intact");
+    service->stop();
+
+    // Simulate a crash in the middle of appending a record
+    const QStringList segments =
+        QDir(journalDir).entryList(QStringList("journal-*.log"), QDir::Files);
+    QVERIFY(!segments.isEmpty());
+    QFile segment(QDir(journalDir).filePath(segments.last()));
+    QVERIFY(segment.open(QIODevice::Append));
+    segment.write(QByteArray("\x00\x00\x01\x00torn", 8));
+    segment.close();
+
+    {
+        ConfigurationService reloaded;
+        reloaded.setConfigurationFile(tempDir->filePath("config.ini"));
+        QVERIFY(reloaded.initialize());
+        QVERIFY(reloaded.setJournalDirectory(journalDir));
+        QCOMPARE(reloaded.getConfiguration("test/value").toString(),
+                 QString("intact"));
+
+        // New records are appended after the last valid one
+        reloaded.setConfiguration("test/other", "appended");
+        QVERIFY(reloaded.saveConfiguration());
+    }
+
+    ConfigurationService again;
+    again.setConfigurationFile(tempDir->filePath("config.ini"));
+    QVERIFY(again.initialize());
+    QVERIFY(again.setJournalDirectory(journalDir));
+    QCOMPARE(again.getConfiguration("test/value").toString(),
+             QString("intact"));
+    QCOMPARE(again.getConfiguration("test/other").toString(),
+             QString("appended"));
+}
+
+void TestConfigurationService::testJournalCompaction() {
+    const QString journalDir = tempDir->filePath("journal");
+    QSignalSpy finished(service,
+                        &ConfigurationService::configurationSaveFinished);
+    QSignalSpy saved(service, &ConfigurationService::configurationSaved);
+    service->setJournalCompactionThreshold(256);
+    QVERIFY(service->setJournalDirectory(journalDir));
+
+    for (int i = 0; i < 100; ++i) {
+        service->setConfiguration(QString("test/key%1").arg(i), i);
+    }
+
+    // Drain: every finished compaction may start one more
+    QTRY_VERIFY(saved.count() >= 1);
+    int compactions = 0;
+    do {
+        compactions = saved.count();
+        QVERIFY(service->waitForPendingSaves(5000));
+        QCoreApplication::processEvents();
+    } while (saved.count() != compactions);
+
+    // Compactions due to the threshold are not answers to any request
+    QCOMPARE(finished.count(), 0);
+
+    // Folded segments are gone; only the one being appended to remains
+    QDir dir(journalDir);
+    QVERIFY(dir.exists("snapshot.dat"));
+    QCOMPARE(dir.entryList(QStringList("journal-*.log"), QDir::Files).size(),
+             1);
+
+    // A compaction requested while one runs is run afterwards, not dropped
+    service->saveConfigurationAsync();
+    service->saveConfigurationAsync();
+    QTRY_COMPARE(finished.count(), 2);
+    QVERIFY(finished.at(0).at(0).toBool());
+    QVERIFY(finished.at(1).at(0).toBool());
+
+    service->stop();
+
+    ConfigurationService reloaded;
+    reloaded.setConfigurationFile(tempDir->filePath("config.ini"));
+    QVERIFY(reloaded.initialize());
+    QVERIFY(reloaded.setJournalDirectory(journalDir));
+    for (int i = 0; i < 100; ++i) {
+        QCOMPARE(reloaded.getConfiguration(QString("test/key%1").arg(i))
+                     .toInt(),
+                 i);
+    }
+}
+
+QTEST_MAIN(TestConfigurationService)
+#include "test_configuration_service.moc"